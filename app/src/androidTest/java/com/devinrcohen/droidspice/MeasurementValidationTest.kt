@@ -0,0 +1,61 @@
+package com.devinrcohen.droidspice
+
+import androidx.test.core.app.ActivityScenario
+import androidx.test.ext.junit.runners.AndroidJUnit4
+
+import org.junit.Test
+import org.junit.runner.RunWith
+
+import org.junit.Assert.*
+
+/**
+ * Checks the native measurement kernels against ngspice's own "meas" on real
+ * simulator output, using validateMeasurements' "name: native=.. ngspice=.. rel=.." report.
+ */
+@RunWith(AndroidJUnit4::class)
+class MeasurementValidationTest {
+    // 1k / 1u: tau = 1 ms, corner 159.15 Hz
+    private val rcDeck = "RC STEP\nV1 in 0 PULSE(0 1 0 1n 1n 1 2) ac 1\nR1 in out 1k\nC1 out 0 1u\n.end\n"
+
+    private fun relErrors(report: String): Map<String, Double> {
+        assertFalse(report, report.contains("meas failed"))
+        val line = Regex("""^(\w+): native=\S+ ngspice=\S+ rel=(\S+)$""")
+        return report.lines().mapNotNull { line.find(it.trim()) }
+            .associate { it.groupValues[1] to it.groupValues[2].toDouble() }
+    }
+
+    private fun withActivity(block: (MainActivity) -> Unit) {
+        ActivityScenario.launch(MainActivity::class.java).use { scenario ->
+            scenario.onActivity(block)
+        }
+    }
+
+    @Test
+    fun tranMatchesNgspiceMeas() = withActivity { activity ->
+        activity.runAnalysis(rcDeck, "tran 2u 10m")
+        val mask = Measurement.maskOf(Measurement.RISE_TIME, Measurement.RMS,
+                                      Measurement.AVERAGE, Measurement.PEAK_TO_PEAK)
+        val params = doubleArrayOf(0.0, 1.0)
+
+        val rel = relErrors(activity.validateMeasurements("", "v(out)", "time", mask, params))
+        assertEquals(setOf("meas_trise", "meas_rms", "meas_avg", "meas_pp"), rel.keys)
+        rel.forEach { (name, err) -> assertTrue("$name rel=$err", err < 1e-3) }
+
+        // and against the analytic 10-90% rise time, tau * ln 9
+        val native = activity.measureVector("", "v(out)", "time", mask, params)
+        assertEquals(1e-3 * Math.log(9.0), native[Measurement.RISE_TIME.ordinal], 1e-3 * 0.01)
+    }
+
+    @Test
+    fun acMatchesNgspiceMeas() = withActivity { activity ->
+        activity.runAnalysis(rcDeck, "ac dec 200 1 100k")
+        val mask = Measurement.maskOf(Measurement.BANDWIDTH_3DB)
+
+        val rel = relErrors(activity.validateMeasurements("", "v(out)", "frequency", mask, doubleArrayOf()))
+        assertEquals(setOf("meas_bw"), rel.keys)
+        assertTrue("meas_bw rel=${rel["meas_bw"]}", rel.getValue("meas_bw") < 1e-3)
+
+        val native = activity.measureVector("", "v(out)", "frequency", mask, doubleArrayOf())
+        assertEquals(1.0 / (2 * Math.PI * 1e-3), native[Measurement.BANDWIDTH_3DB.ordinal], 0.5)
+    }
+}
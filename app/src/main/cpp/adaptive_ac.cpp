@@ -0,0 +1,189 @@
+#include "adaptive_ac.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const double kDbFloor = -300.0;
+
+static double dbAt(const double* row, size_t v)
+{
+    const double re = row[2 * v], im = row[2 * v + 1];
+    const double p = re * re + im * im;
+    return (p > 0.0) ? std::max(10.0 * std::log10(p), kDbFloor) : kDbFloor;
+}
+
+static double phaseStepDeg(const double* a, const double* b, size_t v)
+{
+    double d = (std::atan2(b[2 * v + 1], b[2 * v]) - std::atan2(a[2 * v + 1], a[2 * v])) * 180.0 / M_PI;
+    while (d > 180.0) d -= 360.0;
+    while (d <= -180.0) d += 360.0;
+    return std::fabs(d);
+}
+
+// A flag that does not improve on the earlier flag it was refined from: of
+// the previous flags containing its midpoint, the one centred closest to it.
+static bool stalled(double f1, double f2, double error, const std::vector<RefineInterval>& previous)
+{
+    const double mid = 0.5 * (f1 + f2);
+    const RefineInterval* parent = nullptr;
+    for (const auto& p : previous) {
+        if (mid < p.f1 || mid > p.f2) continue;
+        if (!parent || std::fabs(0.5 * (p.f1 + p.f2) - mid) < std::fabs(0.5 * (parent->f1 + parent->f2) - mid)) {
+            parent = &p;
+        }
+    }
+    return parent && error >= parent->error;
+}
+
+std::vector<RefineInterval> findRefineIntervals(const std::vector<double>& rows, size_t vecCount,
+                                                size_t freqIndex, const AcRefineConfig& cfg,
+                                                std::vector<RefineInterval>& history)
+{
+    std::vector<RefineInterval> out;
+    const std::vector<RefineInterval> previous = std::move(history);
+    history.clear();
+    const size_t rowLen = 2 * vecCount;
+    const size_t n = rowLen ? rows.size() / rowLen : 0;
+    if (n < 2 || !(cfg.dbTolerance > 0.0) || !(cfg.phaseToleranceDeg > 0.0)) return out;
+
+    auto freq = [&](size_t i) { return rows[i * rowLen + 2 * freqIndex]; };
+    auto row = [&](size_t i) { return rows.data() + i * rowLen; };
+    auto flag = [&](size_t i0, size_t i1, double points, double error) {
+        const double f1 = freq(i0), f2 = freq(i1);
+        if (f1 <= 0.0 || f2 - f1 <= cfg.minRelWidth * f1) return;
+        if (stalled(f1, f2, error, previous)) return;
+        // clamp before converting: a huge ratio must not overflow the int
+        out.push_back({f1, f2, (int) std::min(std::max(points, 4.0), (double) cfg.refinePoints), error});
+    };
+
+    // Deep stop-bands sit on numerical noise (or the dB floor), whose
+    // "curvature" and phase are meaningless: test only points within
+    // magnitudeFloorDb of the largest magnitude in the whole plot. A vector
+    // that is nothing but noise (a balanced bridge, the tail of a symmetric
+    // pair) is then skipped entirely instead of being judged against itself.
+    double plotPeak = kDbFloor;
+    for (size_t v = 0; v < vecCount; ++v) {
+        if (v == freqIndex) continue;
+        for (size_t i = 0; i < n; ++i) plotPeak = std::max(plotPeak, dbAt(row(i), v));
+    }
+    const double cutoff = plotPeak - cfg.magnitudeFloorDb;
+    auto significant = [&](size_t i, size_t v) { return dbAt(row(i), v) > cutoff; };
+
+    for (size_t i = 0; i + 1 < n; ++i) {
+        // Phase: a large step between neighbours means an unresolved pole/zero
+        // pair. The step shrinks linearly with spacing.
+        double worstStep = 0.0;
+        for (size_t v = 0; v < vecCount; ++v) {
+            if (v == freqIndex) continue;
+            if (!significant(i, v) && !significant(i + 1, v)) continue;
+            worstStep = std::max(worstStep, phaseStepDeg(row(i), row(i + 1), v));
+        }
+        if (worstStep > cfg.phaseToleranceDeg) {
+            const double error = worstStep / cfg.phaseToleranceDeg;
+            flag(i, i + 1, std::ceil(error) + 1.0, error);
+        }
+
+        // Curvature: how far the middle point sits from the straight line
+        // (in dB vs log f) through its neighbours. That error shrinks with the
+        // square of the spacing, so each of the two steps is split sqrt(err/tol) ways.
+        if (i == 0 || freq(i - 1) <= 0.0) continue;
+        const double l0 = std::log10(freq(i - 1)), l1 = std::log10(freq(i)), l2 = std::log10(freq(i + 1));
+        if (l2 <= l0) continue;
+        const double t = (l1 - l0) / (l2 - l0);
+        double worstErr = 0.0;
+        for (size_t v = 0; v < vecCount; ++v) {
+            if (v == freqIndex) continue;
+            if (!significant(i - 1, v) || !significant(i, v) || !significant(i + 1, v)) continue;
+            const double d0 = dbAt(row(i - 1), v), d1 = dbAt(row(i), v), d2 = dbAt(row(i + 1), v);
+            worstErr = std::max(worstErr, std::fabs(d1 - (d0 + t * (d2 - d0))));
+        }
+        if (worstErr > cfg.dbTolerance) {
+            const double error = worstErr / cfg.dbTolerance;
+            flag(i - 1, i + 1, 2.0 * std::ceil(std::sqrt(error)) + 1.0, error);
+        }
+    }
+
+    std::sort(out.begin(), out.end(),
+              [](const RefineInterval& a, const RefineInterval& b) { return a.f1 < b.f1; });
+    history = out;
+    std::vector<RefineInterval> merged;
+    for (RefineInterval iv : out) {
+        if (!merged.empty() && iv.f1 < merged.back().f2) {
+            RefineInterval& m = merged.back();
+            const double density = (iv.points - 1) / (iv.f2 - iv.f1);
+            // Chaining neighbouring flags could swallow whole decades, which
+            // one refinement run would then cover far too thinly.
+            if (std::max(m.f2, iv.f2) <= cfg.maxLinearRatio * m.f1) {
+                // keep the denser of the two requests over the combined span
+                const double merge = std::max((m.points - 1) / (m.f2 - m.f1), density);
+                m.f2 = std::max(m.f2, iv.f2);
+                m.points = (int) std::min((double) cfg.refinePoints, std::ceil(merge * (m.f2 - m.f1)) + 1.0);
+                m.error = std::max(m.error, iv.error);
+                continue;
+            }
+            // Too wide to merge: start where the previous run ends (a sweep
+            // point already) so the shared span is not solved twice.
+            if (iv.f2 <= m.f2) {
+                m.error = std::max(m.error, iv.error);
+                continue;
+            }
+            iv.f1 = m.f2;
+            iv.points = (int) std::max(3.0, std::ceil(density * (iv.f2 - iv.f1)) + 1.0);
+        }
+        merged.push_back(iv);
+    }
+    return merged;
+}
+
+std::string refineCommand(const RefineInterval& iv, const AcRefineConfig& cfg)
+{
+    char cmd[128];
+    const double ratio = iv.f2 / iv.f1;
+    if (ratio > cfg.maxLinearRatio) {
+        const int ppd = std::max(1, (int) std::ceil((iv.points - 1) / std::log10(ratio)));
+        const double step = std::pow(10.0, 1.0 / ppd);
+        std::snprintf(cmd, sizeof cmd, "ac dec %d %.17g %.17g", ppd, iv.f1 * step, iv.f2 / std::sqrt(step));
+    } else {
+        const double h = (iv.f2 - iv.f1) / (iv.points - 1);
+        std::snprintf(cmd, sizeof cmd, "ac lin %d %.17g %.17g", iv.points - 2, iv.f1 + h, iv.f2 - h);
+    }
+    return cmd;
+}
+
+void mergeSweepRows(std::vector<double>& rows, const std::vector<double>& extra, size_t vecCount,
+                    size_t freqIndex)
+{
+    const size_t rowLen = 2 * vecCount;
+    if (rowLen == 0 || extra.empty()) return;
+
+    const size_t na = rows.size() / rowLen, nb = extra.size() / rowLen;
+    std::vector<double> out;
+    out.reserve(rows.size() + extra.size());
+
+    auto fa = [&](size_t i) { return rows[i * rowLen + 2 * freqIndex]; };
+    auto fb = [&](size_t i) { return extra[i * rowLen + 2 * freqIndex]; };
+    auto append = [&](const std::vector<double>& src, size_t i) {
+        const double f = src[i * rowLen + 2 * freqIndex];
+        if (!out.empty()) {
+            const double last = out[out.size() - rowLen + 2 * freqIndex];
+            if (std::fabs(f - last) <= 1e-12 * std::max(std::fabs(f), std::fabs(last))) return;
+        }
+        out.insert(out.end(), src.begin() + i * rowLen, src.begin() + (i + 1) * rowLen);
+    };
+
+    // extra may hold several refinement runs back to back, so sort it first
+    std::vector<size_t> order(nb);
+    for (size_t i = 0; i < nb; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return fb(a) < fb(b); });
+
+    size_t i = 0, j = 0;
+    while (i < na || j < nb) {
+        if (j >= nb || (i < na && fa(i) <= fb(order[j]))) {
+            append(rows, i++);
+        } else {
+            append(extra, order[j++]);
+        }
+    }
+    rows.swap(out);
+}
@@ -0,0 +1,49 @@
+#ifndef DROIDSPICE_ADAPTIVE_AC_H
+#define DROIDSPICE_ADAPTIVE_AC_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Sweeps are row-major like g_samples with stride 2: each row holds
+// (re, im) for vecCount vectors, one of which (freqIndex) is the frequency scale.
+
+struct AcRefineConfig {
+    int refinePoints = 16;           // points per "ac lin" refinement run
+    double dbTolerance = 0.5;        // max deviation of a point from its neighbours' log-f interpolation
+    double phaseToleranceDeg = 10.0; // max phase step between adjacent points
+    double minRelWidth = 1e-6;       // intervals narrower than this (relative to f) are left alone
+    double maxLinearRatio = 2.0;     // merged intervals stay within f2/f1 <= this; wider ones want "ac dec"
+    double magnitudeFloorDb = 120.0; // points this far below the plot's largest magnitude are not tested
+};
+
+struct RefineInterval {
+    double f1;
+    double f2;
+    int points;                      // wanted points across [f1, f2], endpoints included
+    double error;                    // worst miss, in multiples of the tolerance (> 1)
+};
+
+// Frequency intervals that need more points, sorted and non-overlapping. The
+// point count follows from how far the interval misses the tolerance, so
+// gentle slopes get a few points and sharp features up to refinePoints.
+// Overlapping flags are merged while the result stays within maxLinearRatio
+// and clipped to the previous interval beyond that.
+// history carries the individual flags from one pass to the next (start with
+// it empty): a flag whose error did not drop below that of the earlier flag
+// it lies in (a discontinuity, or noise) is not refined again.
+std::vector<RefineInterval> findRefineIntervals(const std::vector<double>& rows, size_t vecCount,
+                                                size_t freqIndex, const AcRefineConfig& cfg,
+                                                std::vector<RefineInterval>& history);
+
+// The ngspice command solving the interior points of an interval (its
+// endpoints are already in the sweep): "ac lin" within maxLinearRatio,
+// "ac dec" across anything wider.
+std::string refineCommand(const RefineInterval& iv, const AcRefineConfig& cfg);
+
+// Merge extra rows into rows, keeping them sorted by frequency and dropping
+// duplicate frequencies (refinement runs share their endpoints with the coarse sweep).
+void mergeSweepRows(std::vector<double>& rows, const std::vector<double>& extra, size_t vecCount,
+                    size_t freqIndex);
+
+#endif // DROIDSPICE_ADAPTIVE_AC_H
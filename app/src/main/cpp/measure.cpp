@@ -0,0 +1,260 @@
+#include "measure.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double kNaN = std::numeric_limits<double>::quiet_NaN();
+// 20*log10(1/sqrt(2)): the half-power point
+static const double kHalfPowerDb = -3.0102999566398120;
+
+static const uint32_t kStepMask = (1u << MEAS_BANDWIDTH_3DB) - 1u;
+static const uint32_t kFreqMask = ((1u << MEAS_COUNT) - 1u) & ~kStepMask;
+
+// Linear interpolation of the scale value where y crosses level between
+// (x0, y0) and (x1, y1). Same convention as ngspice's meas WHEN/TRIG/TARG.
+static double crossAt(double x0, double y0, double x1, double y1, double level)
+{
+    const double dy = y1 - y0;
+    if (dy == 0.0) return x1;
+    return x0 + (level - y0) * (x1 - x0) / dy;
+}
+
+static bool crossesRising(double yPrev, double y, double level)
+{
+    return yPrev < level && y >= level;
+}
+
+static bool crossesFalling(double yPrev, double y, double level)
+{
+    return yPrev > level && y <= level;
+}
+
+WaveMeasurer::WaveMeasurer(uint32_t mask, const MeasureParams& params)
+    : m_mask(mask), m_params(params)
+{
+}
+
+void WaveMeasurer::reset()
+{
+    const uint32_t mask = m_mask;
+    const MeasureParams params = m_params;
+    *this = WaveMeasurer(mask, params);
+}
+
+void WaveMeasurer::push(double x, double re, double im)
+{
+    if (m_count == 0) m_x0 = x;
+
+    // Sample-rate work only for the families that were asked for: transient
+    // data streams through sendData and should not pay for log10/atan2.
+    if (m_mask & kStepMask) pushStep(x, re);
+    if (m_mask & kFreqMask) pushFreq(x, re, im);
+
+    m_xPrev = x;
+    m_yPrev = re;
+    ++m_count;
+}
+
+void WaveMeasurer::pushStep(double x, double y)
+{
+    if (m_count == 0) {
+        m_yMin = m_yMax = y;
+
+        m_initial = std::isnan(m_params.initialValue) ? y : m_params.initialValue;
+        const double fin = m_params.finalValue;
+        m_haveLevels = !std::isnan(fin) && fin != m_initial;
+        if (m_haveLevels) {
+            const double a = m_initial + m_params.lowFraction * (fin - m_initial);
+            const double b = m_initial + m_params.highFraction * (fin - m_initial);
+            m_lowLevel = std::min(a, b);
+            m_highLevel = std::max(a, b);
+
+            const double band = m_params.settleTolerance * std::fabs(fin - m_initial);
+            m_inBand = std::fabs(y - fin) <= band;
+            m_settleX = x;
+        }
+        return;
+    }
+
+    // Trapezoidal integration over the (possibly non-uniform) scale
+    const double dx = x - m_xPrev;
+    m_intY += 0.5 * (y + m_yPrev) * dx;
+    m_intY2 += 0.5 * (y * y + m_yPrev * m_yPrev) * dx;
+    m_yMin = std::min(m_yMin, y);
+    m_yMax = std::max(m_yMax, y);
+
+    if (!m_haveLevels) return;
+
+    // Rise/fall: trigger and target are independent first crossings, as in
+    // "meas tran t TRIG v VAL=lo RISE=1 TARG v VAL=hi RISE=1"
+    if (!m_haveRiseTrig && crossesRising(m_yPrev, y, m_lowLevel)) {
+        m_riseTrig = crossAt(m_xPrev, m_yPrev, x, y, m_lowLevel);
+        m_haveRiseTrig = true;
+    }
+    if (!m_haveRiseTarg && crossesRising(m_yPrev, y, m_highLevel)) {
+        m_riseTarg = crossAt(m_xPrev, m_yPrev, x, y, m_highLevel);
+        m_haveRiseTarg = true;
+    }
+    if (!m_haveFallTrig && crossesFalling(m_yPrev, y, m_highLevel)) {
+        m_fallTrig = crossAt(m_xPrev, m_yPrev, x, y, m_highLevel);
+        m_haveFallTrig = true;
+    }
+    if (!m_haveFallTarg && crossesFalling(m_yPrev, y, m_lowLevel)) {
+        m_fallTarg = crossAt(m_xPrev, m_yPrev, x, y, m_lowLevel);
+        m_haveFallTarg = true;
+    }
+
+    // Settling: remember where the trace last entered the tolerance band
+    const double fin = m_params.finalValue;
+    const double band = m_params.settleTolerance * std::fabs(fin - m_initial);
+    const bool inBand = std::fabs(y - fin) <= band;
+    if (inBand && !m_inBand) {
+        const double edge = (m_yPrev > fin) ? fin + band : fin - band;
+        m_settleX = crossAt(m_xPrev, m_yPrev, x, y, edge);
+    }
+    m_inBand = inBand;
+}
+
+void WaveMeasurer::pushFreq(double f, double re, double im)
+{
+    const double mag2 = re * re + im * im;
+    const double db = (mag2 > 0.0) ? 10.0 * std::log10(mag2)
+                                   : -std::numeric_limits<double>::infinity();
+    const double rawPhase = std::atan2(im, re) * 180.0 / M_PI;
+
+    if (m_count == 0) {
+        m_refDb = db;
+        m_phasePrev = rawPhase;
+        m_rawPhasePrev = rawPhase;
+        m_dbPrev = db;
+        m_peakF = f;
+        m_peakDb = db;
+        m_dbStack.push_back({f, db, f, db});
+        return;
+    }
+
+    // Unwrap phase against the previous point
+    double dp = rawPhase - m_rawPhasePrev;
+    while (dp > 180.0) dp -= 360.0;
+    while (dp <= -180.0) dp += 360.0;
+    const double phase = m_phasePrev + dp;
+
+    if (!m_haveBandwidth && crossesFalling(m_dbPrev, db, m_refDb + kHalfPowerDb)) {
+        m_bandwidth = crossAt(m_xPrev, m_dbPrev, f, db, m_refDb + kHalfPowerDb);
+        m_haveBandwidth = true;
+    }
+    if (!m_haveGainMargin && crossesFalling(m_phasePrev, phase, -180.0)) {
+        const double fx = crossAt(m_xPrev, m_phasePrev, f, phase, -180.0);
+        const double t = (f != m_xPrev) ? (fx - m_xPrev) / (f - m_xPrev) : 1.0;
+        m_gainMargin = -(m_dbPrev + t * (db - m_dbPrev));
+        m_haveGainMargin = true;
+    }
+    if (!m_havePhaseMargin && crossesFalling(m_dbPrev, db, 0.0)) {
+        const double fx = crossAt(m_xPrev, m_dbPrev, f, db, 0.0);
+        const double t = (f != m_xPrev) ? (fx - m_xPrev) / (f - m_xPrev) : 1.0;
+        m_phaseMargin = 180.0 + m_phasePrev + t * (phase - m_phasePrev);
+        m_havePhaseMargin = true;
+    }
+
+    if (wants(MEAS_RESONANCE_FREQ) || wants(MEAS_RESONANCE_Q)) {
+        // The previous point is always on top of the stack; record its successor.
+        m_dbStack.back().nextF = f;
+        m_dbStack.back().nextDb = db;
+
+        if (db > m_peakDb) {
+            m_peakF = f;
+            m_peakDb = db;
+            m_havePeakHigh = false;
+
+            // Lower half-power point: the last earlier point below the
+            // threshold. The stack keeps exactly the candidates for that query.
+            const double level = db + kHalfPowerDb;
+            auto it = std::lower_bound(m_dbStack.begin(), m_dbStack.end(), level,
+                                       [](const DbPoint& p, double v) { return p.db < v; });
+            if (it != m_dbStack.begin()) {
+                const DbPoint& p = *(it - 1);
+                m_peakLowF = crossAt(p.f, p.db, p.nextF, p.nextDb, level);
+                m_havePeakLow = true;
+            } else {
+                m_havePeakLow = false;
+            }
+        } else if (!m_havePeakHigh && crossesFalling(m_dbPrev, db, m_peakDb + kHalfPowerDb)) {
+            m_peakHighF = crossAt(m_xPrev, m_dbPrev, f, db, m_peakDb + kHalfPowerDb);
+            m_havePeakHigh = true;
+        }
+
+        while (!m_dbStack.empty() && m_dbStack.back().db >= db) {
+            m_dbStack.pop_back();
+        }
+        m_dbStack.push_back({f, db, f, db});
+    }
+
+    m_rawPhasePrev = rawPhase;
+    m_phasePrev = phase;
+    m_dbPrev = db;
+}
+
+std::vector<double> WaveMeasurer::finish() const
+{
+    std::vector<double> r(MEAS_COUNT, kNaN);
+    if (m_count == 0) return r;
+
+    const double span = m_xPrev - m_x0;
+
+    if (wants(MEAS_RMS)) {
+        r[MEAS_RMS] = (span > 0.0) ? std::sqrt(m_intY2 / span) : std::fabs(m_yPrev);
+    }
+    if (wants(MEAS_AVERAGE)) {
+        r[MEAS_AVERAGE] = (span > 0.0) ? m_intY / span : m_yPrev;
+    }
+    if (wants(MEAS_PEAK_TO_PEAK)) {
+        r[MEAS_PEAK_TO_PEAK] = m_yMax - m_yMin;
+    }
+
+    if (m_haveLevels) {
+        const double fin = m_params.finalValue;
+        if (wants(MEAS_RISE_TIME) && m_haveRiseTrig && m_haveRiseTarg) {
+            r[MEAS_RISE_TIME] = m_riseTarg - m_riseTrig;
+        }
+        if (wants(MEAS_FALL_TIME) && m_haveFallTrig && m_haveFallTarg) {
+            r[MEAS_FALL_TIME] = m_fallTarg - m_fallTrig;
+        }
+        if (wants(MEAS_OVERSHOOT)) {
+            const double step = fin - m_initial;
+            const double beyond = (step > 0.0) ? (m_yMax - fin) : (fin - m_yMin);
+            r[MEAS_OVERSHOOT] = std::max(0.0, beyond) / std::fabs(step) * 100.0;
+        }
+        if (wants(MEAS_SETTLING_TIME) && m_inBand) {
+            r[MEAS_SETTLING_TIME] = m_settleX - m_x0;
+        }
+    }
+
+    if (wants(MEAS_BANDWIDTH_3DB) && m_haveBandwidth) {
+        r[MEAS_BANDWIDTH_3DB] = m_bandwidth;
+    }
+    if (wants(MEAS_GAIN_MARGIN) && m_haveGainMargin) {
+        r[MEAS_GAIN_MARGIN] = m_gainMargin;
+    }
+    if (wants(MEAS_PHASE_MARGIN) && m_havePhaseMargin) {
+        r[MEAS_PHASE_MARGIN] = m_phaseMargin;
+    }
+    if (wants(MEAS_RESONANCE_FREQ)) {
+        r[MEAS_RESONANCE_FREQ] = m_peakF;
+    }
+    if (wants(MEAS_RESONANCE_Q) && m_havePeakLow && m_havePeakHigh && m_peakHighF > m_peakLowF) {
+        r[MEAS_RESONANCE_Q] = m_peakF / (m_peakHighF - m_peakLowF);
+    }
+    return r;
+}
+
+std::vector<double> measureTrace(const double* x, const double* y, size_t n, int stride,
+                                 uint32_t mask, const MeasureParams& params)
+{
+    WaveMeasurer m(mask, params);
+    for (size_t i = 0; i < n; ++i) {
+        const double re = y[i * stride];
+        const double im = (stride == 2) ? y[i * stride + 1] : 0.0;
+        m.push(x[i], re, im);
+    }
+    return m.finish();
+}
@@ -0,0 +1,123 @@
+#ifndef DROIDSPICE_MEASURE_H
+#define DROIDSPICE_MEASURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Measurement kinds. The value is both the bit position in a request mask
+// and the slot index in the result array handed back across JNI, so it must
+// stay in sync with Measurement.kt.
+enum MeasureKind : int {
+    MEAS_RISE_TIME = 0,     // tran: low->high level, first rising crossings
+    MEAS_FALL_TIME,         // tran: high->low level, first falling crossings
+    MEAS_OVERSHOOT,         // tran: percent of step beyond the final value
+    MEAS_SETTLING_TIME,     // tran: time from first sample until the trace stays in band
+    MEAS_RMS,               // tran: sqrt(integral(y^2) / span)
+    MEAS_AVERAGE,           // tran: integral(y) / span
+    MEAS_PEAK_TO_PEAK,      // tran: max - min
+    MEAS_BANDWIDTH_3DB,     // ac: first frequency 3 dB below the first point
+    MEAS_GAIN_MARGIN,       // ac: -gain (dB) where the unwrapped phase crosses -180 deg
+    MEAS_PHASE_MARGIN,      // ac: 180 + phase (deg) where the gain crosses 0 dB
+    MEAS_RESONANCE_FREQ,    // ac: frequency of the magnitude peak
+    MEAS_RESONANCE_Q,       // ac: f0 / (half-power bandwidth around the peak)
+    MEAS_COUNT
+};
+
+// Reference levels for the step-response measurements (rise/fall/overshoot/
+// settling). Like ngspice's "meas ... VAL=", the levels must be known up front
+// so the trace can be measured in one pass; initialValue may be left NaN to
+// take the first sample, finalValue must be supplied or those results are NaN.
+struct MeasureParams {
+    double initialValue = std::numeric_limits<double>::quiet_NaN();
+    double finalValue = std::numeric_limits<double>::quiet_NaN();
+    double lowFraction = 0.1;
+    double highFraction = 0.9;
+    double settleTolerance = 0.02; // fraction of |final - initial|
+};
+
+// Streaming accumulator: push() every (scale, value) point in sweep order,
+// then finish() yields MEAS_COUNT results (NaN where not requested or not
+// determinable). Only the measurement families present in the mask do any
+// per-point work. State is O(1), except that a resonance request keeps a
+// monotone stack to locate the lower half-power point: it holds every point
+// not followed by a lower one, so a magnitude that rises throughout (e.g. a
+// high-pass) keeps O(n) entries.
+class WaveMeasurer {
+public:
+    WaveMeasurer() = default;
+    WaveMeasurer(uint32_t mask, const MeasureParams& params);
+
+    void reset();
+    void push(double x, double re, double im);
+    std::vector<double> finish() const;
+
+    uint32_t mask() const { return m_mask; }
+    size_t count() const { return m_count; }
+
+private:
+    struct DbPoint {
+        double f;
+        double db;
+        double nextF;
+        double nextDb;
+    };
+
+    bool wants(MeasureKind k) const { return (m_mask >> k) & 1u; }
+    void pushStep(double x, double y);
+    void pushFreq(double f, double re, double im);
+
+    uint32_t m_mask = 0;
+    MeasureParams m_params;
+    size_t m_count = 0;
+
+    double m_x0 = 0.0;
+    double m_xPrev = 0.0;
+    double m_yPrev = 0.0;
+
+    // amplitude statistics
+    double m_intY = 0.0;
+    double m_intY2 = 0.0;
+    double m_yMin = 0.0;
+    double m_yMax = 0.0;
+
+    // step response
+    bool m_haveLevels = false;
+    double m_initial = 0.0;
+    double m_lowLevel = 0.0;
+    double m_highLevel = 0.0;
+    double m_riseTrig = 0.0, m_riseTarg = 0.0;
+    double m_fallTrig = 0.0, m_fallTarg = 0.0;
+    bool m_haveRiseTrig = false, m_haveRiseTarg = false;
+    bool m_haveFallTrig = false, m_haveFallTarg = false;
+    bool m_inBand = false;
+    double m_settleX = 0.0;
+
+    // frequency response
+    double m_dbPrev = 0.0;
+    double m_rawPhasePrev = 0.0;
+    double m_phasePrev = 0.0;
+    double m_refDb = 0.0;
+    double m_bandwidth = 0.0;
+    bool m_haveBandwidth = false;
+    double m_gainMargin = 0.0;
+    bool m_haveGainMargin = false;
+    double m_phaseMargin = 0.0;
+    bool m_havePhaseMargin = false;
+
+    double m_peakF = 0.0;
+    double m_peakDb = 0.0;
+    double m_peakLowF = 0.0;
+    double m_peakHighF = 0.0;
+    bool m_havePeakLow = false;
+    bool m_havePeakHigh = false;
+    std::vector<DbPoint> m_dbStack; // strictly increasing dB, bottom to top
+};
+
+// Convenience wrapper for a vector that is already fully captured.
+// stride is 1 for real data and 2 for interleaved (re, im).
+std::vector<double> measureTrace(const double* x, const double* y, size_t n, int stride,
+                                 uint32_t mask, const MeasureParams& params);
+
+#endif // DROIDSPICE_MEASURE_H
@@ -10,11 +10,19 @@
 #include <cstdlib>
 #include <cstring>
 #include <limits>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <map>
 
 extern "C" {
 #include <ngspice/sharedspice.h>
 }
 
+#include "measure.h"
+#include "spectrum.h"
+#include "adaptive_ac.h"
+
 //static bool g_initialized = false;
 static std::atomic<bool> g_initialized{false};
 static std::atomic<bool> g_hasLoadedCircuit{false};
@@ -37,6 +45,48 @@ static int g_vecCount = 0;
 static std::vector<double> g_samples;
 static bool g_storeComplex = false;
 
+// Streaming measurement session (guarded by g_dataMutex).
+// Armed from Kotlin before an analysis; the session binds to the first
+// analysis whose vectors include both names (sendInitData resolves the
+// indices) and sendData feeds every point of that analysis only. The next
+// analysis ends the feed, so a batch or a multi-run sweep cannot silently
+// replace the results with those of its last sub-run. While suspended
+// (adaptive AC), nothing binds and the caller measures its merged result.
+static bool g_measArmed = false;
+static bool g_measBound = false;
+static bool g_measSuspended = false;
+static std::string g_measVecName;
+static std::string g_measScaleName;
+static int g_measVecIndex = -1;
+static int g_measScaleIndex = -1;
+static WaveMeasurer g_measurer;
+
+// Results kept per ngspice plot (op1, ac1, tran1, ...) so several analyses of
+// one loaded circuit can coexist. Guarded by g_dataMutex; cleared whenever a
+// different circuit is loaded, since that destroys the plots as well.
+struct PlotData {
+    std::string command;
+    std::vector<std::string> vecNames;
+    std::vector<double> samples;   // row-major, same layout as g_samples
+    bool complex = false;
+};
+static std::map<std::string, PlotData> g_plots;
+static std::vector<std::string> g_plotOrder;
+
+// Netlist currently parsed by ngspice (guarded by g_spiceMutex), so a repeat
+// run of the same deck skips the destroy/reset/reload.
+static std::string g_loadedNetlist;
+
+static void storePlot(const std::string& plot, PlotData data)
+{
+    if (g_plots.find(plot) == g_plots.end()) g_plotOrder.push_back(plot);
+    g_plots[plot] = std::move(data);
+}
+
+// Last spectrum computed by analyzeSpectrum (guarded by g_dataMutex).
+// Row-major [frequency, magnitude, phaseDeg] per bin.
+static std::vector<double> g_spectrum;
+
 // Background thread running flag (for analyses that execute async inside ngspice)
 static std::mutex g_bgMutex;
 static std::condition_variable g_bgCv;
@@ -82,6 +132,14 @@ static std::string takeOutputSnapshot()
     return g_output;
 }
 
+static std::string lowerCopy(const std::string& s)
+{
+    std::string low;
+    low.reserve(s.size());
+    for (unsigned char ch : s) low.push_back(static_cast<char>(std::tolower(ch)));
+    return low;
+}
+
 /* -------------------- ngspice callbacks -------------------- */
 
 extern "C" int sendChar(char* msg, int /*id*/, void* /*user*/)
@@ -127,6 +185,11 @@ extern "C" int sendData(pvecvaluesall vec, int /*num*/, int /*id*/, void* /*user
         }
     }
 
+    if (g_measBound && g_measVecIndex < n && g_measScaleIndex < n) {
+        const pvecvalues v = vec->vecsa[g_measVecIndex];
+        g_measurer.push(vec->vecsa[g_measScaleIndex]->creal, v->creal, v->cimag);
+    }
+
     return 0;
 }
 
@@ -144,6 +207,25 @@ extern "C" int sendInitData(pvecinfoall info, int /*id*/, void* /*user*/)
     {
         g_vecNames.emplace_back(info->vecs[i]->vecname);
     }
+
+    if (g_measBound) {
+        // The bound analysis is over; its results stay until takeMeasurements.
+        g_measBound = false;
+    } else if (g_measArmed && !g_measSuspended) {
+        int vecIndex = -1, scaleIndex = -1;
+        for (int i = 0; i < g_vecCount; ++i) {
+            const std::string name = lowerCopy(g_vecNames[i]);
+            if (name == g_measVecName) vecIndex = i;
+            if (name == g_measScaleName) scaleIndex = i;
+        }
+        if (vecIndex >= 0 && scaleIndex >= 0) {
+            g_measVecIndex = vecIndex;
+            g_measScaleIndex = scaleIndex;
+            g_measurer.reset();
+            g_measArmed = false;
+            g_measBound = true;
+        }
+    }
     return 0;
 }
 
@@ -196,6 +278,17 @@ static bool lineContainsDotEnd(const std::string& line)
 
 /* -------------------- JNI -------------------- */
 
+static jobjectArray toJStringArray(JNIEnv* env, const std::vector<std::string>& v)
+{
+    jclass strClass = env->FindClass("java/lang/String");
+    jobjectArray arr = env->NewObjectArray((jsize)v.size(), strClass, nullptr);
+    for (jsize i = 0; i < (jsize)v.size(); ++i)
+    {
+        env->SetObjectArrayElement(arr, i, env->NewStringUTF(v[i].c_str()));
+    }
+    return arr;
+}
+
 extern "C"
 JNIEXPORT jstring JNICALL
 Java_com_devinrcohen_droidspice_MainActivity_initNgspice(JNIEnv* env, jobject /*thiz*/)
@@ -309,6 +402,120 @@ static bool analysisRequiresComplex(const std::string& cmd)
     return (low.rfind("ac", 0) == 0);
 }
 
+// Caller holds g_spiceMutex.
+static int loadCircuit(const std::string& netlistStr)
+{
+    // Same deck as last time: keep the parsed circuit and every plot it has
+    // produced, so op/ac/tran results of one circuit coexist in g_plots.
+    if (g_hasLoadedCircuit.load(std::memory_order_acquire) && netlistStr == g_loadedNetlist) {
+        return 0;
+    }
+
+    // Start from a clean ngspice state.
+    // may complain on the first run because no circuit given, so nothing to "destroy" or "reset"
+    // So check to see if a circuit has even been loaded yet
+    // Clean ngspice state only after we've ever loaded a circuit.
+    if (g_hasLoadedCircuit.load(std::memory_order_acquire)) {
+        runCommand("destroy all");
+        runCommand("reset");
+        clearOutput();
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(g_dataMutex);
+        g_plots.clear();
+        g_plotOrder.clear();
+    }
+
+    // Build and load deck.
+    std::vector<char*> deck = buildDeck(netlistStr);
+    int rc = runCirc(deck.data());
+    if (rc == 0) g_hasLoadedCircuit.store(true, std::memory_order_release);
+    g_loadedNetlist = (rc == 0) ? netlistStr : std::string();
+    freeDeck(deck);
+    return rc;
+}
+
+// Caller holds g_spiceMutex.
+static void runAnalysisCommand(const std::string& cmd)
+{
+    setBgRunning(false);
+    runCommand(cmd.c_str());
+    waitBgDone();
+}
+
+static std::vector<std::string> allPlotNames()
+{
+    std::vector<std::string> names;
+    char** plots = ngSpice_AllPlots();
+    for (int i = 0; plots && plots[i]; ++i) names.emplace_back(plots[i]);
+    return names;
+}
+
+// Re-running a command on the same circuit supersedes its earlier result:
+// drop the older plots from ngspice and the store so repeats don't pile up.
+// Caller holds g_spiceMutex (not g_dataMutex).
+static void supersedePlots(const std::string& command, const std::string& keep)
+{
+    std::vector<std::string> stale;
+    {
+        std::lock_guard<std::mutex> lk(g_dataMutex);
+        for (const std::string& name : g_plotOrder) {
+            if (name != keep && g_plots[name].command == command) stale.push_back(name);
+        }
+        for (const std::string& name : stale) {
+            g_plots.erase(name);
+            g_plotOrder.erase(std::find(g_plotOrder.begin(), g_plotOrder.end(), name));
+        }
+    }
+    for (const std::string& name : stale) runCommand(("destroy " + name).c_str());
+}
+
+// Run an analysis and return the plot it created, or "" if it left no new
+// plot (e.g. it failed): the current plot is then some older result, which
+// must not be mistaken for this one's. Caller holds g_spiceMutex.
+static std::string runForNewPlot(const std::string& cmd)
+{
+    const std::vector<std::string> before = allPlotNames();
+    runAnalysisCommand(cmd);
+
+    // A successful analysis leaves a new current plot behind.
+    const char* cur = ngSpice_CurPlot();
+    const std::string plot = cur ? cur : "";
+    if (plot.empty() || std::find(before.begin(), before.end(), plot) != before.end()) {
+        return "";
+    }
+    return plot;
+}
+
+// Run one analysis and file its streamed vectors under the plot it created.
+// drain moves the data out of g_samples/g_vecNames; otherwise it is copied so
+// getVecNames/takeSamples still see it. Returns the plot name, or "" if the
+// command left no new plot. Caller holds g_spiceMutex.
+static std::string runAndRecord(const std::string& cmd, bool drain)
+{
+    g_storeComplex = analysisRequiresComplex(cmd);
+    const std::string plot = runForNewPlot(cmd);
+    if (plot.empty()) return "";
+
+    supersedePlots(cmd, plot);
+
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    PlotData data;
+    data.command = cmd;
+    data.complex = g_storeComplex;
+    if (drain) {
+        data.vecNames.swap(g_vecNames);
+        data.samples.swap(g_samples);
+        g_vecCount = 0;
+    } else {
+        data.vecNames = g_vecNames;
+        data.samples = g_samples;
+    }
+    storePlot(plot, std::move(data));
+    return plot;
+}
+
 extern "C"
 JNIEXPORT jstring JNICALL
 Java_com_devinrcohen_droidspice_MainActivity_runAnalysis(JNIEnv* env, jobject /*thiz*/, jstring netlist, jstring analysisCmd)
@@ -329,34 +536,17 @@ Java_com_devinrcohen_droidspice_MainActivity_runAnalysis(JNIEnv* env, jobject /*
 
     clearOutput();
 
-    // Start from a clean ngspice state.
-    // may complain on the first run because no circuit given, so nothing to "destroy" or "reset"
-    // So check to see if a circuit has even been loaded yet
-    // Clean ngspice state only after we've ever loaded a circuit.
-    if (g_hasLoadedCircuit.load(std::memory_order_acquire)) {
-        runCommand("destroy all");
-        runCommand("reset");
-        clearOutput();
-    }
-
     // Set stride policy: complex for AC, real otherwise.
     g_storeComplex = analysisRequiresComplex(analysisStr);
 
-    // Build and load deck.
-    std::vector<char*> deck = buildDeck(netlistStr);
-    int rc = runCirc(deck.data());
-    if (rc == 0) g_hasLoadedCircuit.store(true, std::memory_order_release);
-    freeDeck(deck);
-    if (rc != 0) {
+    if (loadCircuit(netlistStr) != 0) {
         // If load failed, return now with whatever ngspice said.
         std::string out = takeOutputSnapshot();
         return env->NewStringUTF(out.c_str());
     }
 
-    // Run the requested analysis.
-    setBgRunning(false);
-    runCommand(analysisStr.c_str());
-    waitBgDone();
+    // Run the requested analysis; the result also lands in the plot store.
+    runAndRecord(analysisStr, false);
 
     std::string out = takeOutputSnapshot();
     return env->NewStringUTF(out.c_str());
@@ -391,12 +581,607 @@ JNIEXPORT jobjectArray JNICALL
 Java_com_devinrcohen_droidspice_MainActivity_getVecNames(JNIEnv* env, jobject /*thiz*/)
 {
     std::lock_guard<std::mutex> lk(g_dataMutex);
+    return toJStringArray(env, g_vecNames);
+}
 
-    jclass strClass = env->FindClass("java/lang/String");
-    jobjectArray arr = env->NewObjectArray((jsize)g_vecNames.size(), strClass, nullptr);
-    for (jsize i = 0; i < (jsize)g_vecNames.size(); ++i)
+/* -------------------- measurements -------------------- */
+
+static std::string jstringToStd(JNIEnv* env, jstring js)
+{
+    if (!js) return "";
+    const char* c = env->GetStringUTFChars(js, nullptr);
+    std::string s = c ? c : "";
+    env->ReleaseStringUTFChars(js, c);
+    return s;
+}
+
+static jdoubleArray toJDoubleArray(JNIEnv* env, const std::vector<double>& v)
+{
+    jdoubleArray arr = env->NewDoubleArray((jsize) v.size());
+    env->SetDoubleArrayRegion(arr, 0, (jsize) v.size(), v.data());
+    return arr;
+}
+
+// params layout: [initialValue, finalValue, lowFraction, highFraction, settleTolerance]
+// Missing trailing entries keep their defaults; NaN initial means "first sample".
+static MeasureParams paramsFromArray(JNIEnv* env, jdoubleArray arr)
+{
+    MeasureParams p;
+    if (!arr) return p;
+    const jsize n = env->GetArrayLength(arr);
+    std::vector<double> v((size_t) n);
+    env->GetDoubleArrayRegion(arr, 0, n, v.data());
+    if (n > 0) p.initialValue = v[0];
+    if (n > 1) p.finalValue = v[1];
+    if (n > 2) p.lowFraction = v[2];
+    if (n > 3) p.highFraction = v[3];
+    if (n > 4) p.settleTolerance = v[4];
+    return p;
+}
+
+// Copy a vector of the current plot out of ngspice.
+// Real vectors come back with stride 1, complex ones interleaved with stride 2.
+static bool fetchVector(const std::string& name, std::vector<double>& out, int& stride)
+{
+    pvector_info info = ngGet_Vec_Info(const_cast<char*>(name.c_str()));
+    if (!info || info->v_length <= 0) return false;
+
+    const size_t n = (size_t) info->v_length;
+    if (info->v_realdata) {
+        stride = 1;
+        out.assign(info->v_realdata, info->v_realdata + n);
+    } else if (info->v_compdata) {
+        stride = 2;
+        out.resize(2 * n);
+        for (size_t i = 0; i < n; ++i) {
+            out[2 * i] = info->v_compdata[i].cx_real;
+            out[2 * i + 1] = info->v_compdata[i].cx_imag;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Scale vectors (time, frequency) are used by their real part only.
+static bool fetchScale(const std::string& name, std::vector<double>& out)
+{
+    std::vector<double> raw;
+    int stride = 1;
+    if (!fetchVector(name, raw, stride)) return false;
+    out.resize(raw.size() / stride);
+    for (size_t i = 0; i < out.size(); ++i) out[i] = raw[i * stride];
+    return true;
+}
+
+// Which plot a vector lives in: an explicit plot argument, else a "plot."
+// prefix naming an existing plot (e.g. "tran1.v(2)"), else the current plot.
+// bare receives the vector name without that prefix. Scale and vector are
+// then both fetched as "<plot>.<name>", so they always share one axis even
+// when the store keeps several plots side by side. Caller holds g_spiceMutex.
+static std::string resolvePlot(const std::string& plotArg, const std::string& vecName, std::string& bare)
+{
+    bare = vecName;
+    if (!plotArg.empty()) return plotArg;
+
+    const size_t dot = vecName.find('.');
+    if (dot != std::string::npos) {
+        const std::string prefix = vecName.substr(0, dot);
+        const std::vector<std::string> plots = allPlotNames();
+        if (std::find(plots.begin(), plots.end(), prefix) != plots.end()) {
+            bare = vecName.substr(dot + 1);
+            return prefix;
+        }
+    }
+    const char* cur = ngSpice_CurPlot();
+    return cur ? cur : "";
+}
+
+static std::vector<double> measurePlot(const std::string& plot, const std::string& vecName,
+                                       const std::string& scaleName, uint32_t mask, const MeasureParams& params)
+{
+    std::vector<double> x, y;
+    int stride = 1;
+    if (plot.empty() || !fetchScale(plot + "." + scaleName, x) || !fetchVector(plot + "." + vecName, y, stride)) {
+        return std::vector<double>(MEAS_COUNT, std::numeric_limits<double>::quiet_NaN());
+    }
+    const size_t n = std::min(x.size(), y.size() / stride);
+    return measureTrace(x.data(), y.data(), n, stride, mask, params);
+}
+
+static std::string fmtDouble(double v)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.17g", v);
+    return buf;
+}
+
+// Run an ngspice "meas" command and read back the vector it leaves in the current plot.
+// The result vector is removed first so a failed meas cannot report a stale value;
+// returns false if the command was rejected or produced no result.
+static bool ngspiceMeas(const std::string& resultName, const std::string& cmd, double& value)
+{
+    runCommand(("unlet " + resultName).c_str());
+    if (runCommand(cmd.c_str()) != 0) return false;
+
+    std::vector<double> v;
+    int stride = 1;
+    if (!fetchVector(resultName, v, stride) || v.empty()) return false;
+    value = v[0];
+    return true;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_armMeasurements(JNIEnv* env, jobject /*thiz*/, jstring vecName,
+                                                             jstring scaleName, jint mask, jdoubleArray params)
+{
+    const std::string vec = lowerCopy(jstringToStd(env, vecName));
+    const std::string scale = lowerCopy(jstringToStd(env, scaleName));
+    const MeasureParams p = paramsFromArray(env, params);
+
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    g_measArmed = true;
+    g_measBound = false;
+    g_measVecName = vec;
+    g_measScaleName = scale;
+    g_measVecIndex = -1;
+    g_measScaleIndex = -1;
+    g_measurer = WaveMeasurer((uint32_t) mask, p);
+}
+
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_takeMeasurements(JNIEnv* env, jobject /*thiz*/)
+{
+    // Safe to call while an analysis is still streaming: results reflect the
+    // points delivered so far. The session is disarmed once taken; if it never
+    // bound to an analysis every result is NaN.
+    std::vector<double> r;
     {
-        env->SetObjectArrayElement(arr, i, env->NewStringUTF(g_vecNames[i].c_str()));
+        std::lock_guard<std::mutex> lk(g_dataMutex);
+        r = g_measurer.finish();
+        g_measArmed = false;
+        g_measBound = false;
     }
-    return arr;
+    return toJDoubleArray(env, r);
+}
+
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_measureVector(JNIEnv* env, jobject /*thiz*/, jstring plotName,
+                                                           jstring vecName, jstring scaleName, jint mask,
+                                                           jdoubleArray params)
+{
+    const std::string plotArg = jstringToStd(env, plotName);
+    const std::string vecArg = jstringToStd(env, vecName);
+    const std::string scale = jstringToStd(env, scaleName);
+    const MeasureParams p = paramsFromArray(env, params);
+
+    std::lock_guard<std::mutex> lock(g_spiceMutex);
+    std::string vec;
+    const std::string plot = resolvePlot(plotArg, vecArg, vec);
+    return toJDoubleArray(env, measurePlot(plot, vec, scale, (uint32_t) mask, p));
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_validateMeasurements(JNIEnv* env, jobject /*thiz*/, jstring plotName,
+                                                                  jstring vecName, jstring scaleName, jint mask,
+                                                                  jdoubleArray params)
+{
+    // Compare the native kernels against ngspice's own "meas" on the same plot.
+    // Only measurements with a direct meas equivalent are checked.
+    const std::string plotArg = jstringToStd(env, plotName);
+    const std::string vecArg = jstringToStd(env, vecName);
+    const std::string scale = jstringToStd(env, scaleName);
+    const MeasureParams p = paramsFromArray(env, params);
+
+    std::lock_guard<std::mutex> lock(g_spiceMutex);
+
+    if (!g_initialized.load(std::memory_order_acquire)) {
+        return env->NewStringUTF("ERROR: ngspice not initialized\n");
+    }
+
+    std::string vec;
+    const std::string plot = resolvePlot(plotArg, vecArg, vec);
+    if (plot.empty()) {
+        return env->NewStringUTF("[WARN] no plot to validate\n");
+    }
+    const std::vector<double> native = measurePlot(plot, vec, scale, (uint32_t) mask, p);
+    const bool isAc = (lowerCopy(scale) == "frequency");
+    const auto wants = [mask](MeasureKind k) { return ((uint32_t) mask >> k) & 1u; };
+
+    struct Check { MeasureKind kind; const char* name; std::string cmd; };
+    std::vector<Check> checks;
+
+    if (!isAc) {
+        std::vector<double> y;
+        int stride = 1;
+        if (fetchVector(plot + "." + vec, y, stride) && !y.empty() && !std::isnan(p.finalValue)) {
+            const double init = std::isnan(p.initialValue) ? y[0] : p.initialValue;
+            const double a = init + p.lowFraction * (p.finalValue - init);
+            const double b = init + p.highFraction * (p.finalValue - init);
+            const std::string lo = fmtDouble(std::min(a, b)), hi = fmtDouble(std::max(a, b));
+            checks.push_back({MEAS_RISE_TIME, "meas_trise",
+                              "meas tran meas_trise TRIG " + vec + " VAL=" + lo + " RISE=1 TARG " + vec
+                              + " VAL=" + hi + " RISE=1"});
+            checks.push_back({MEAS_FALL_TIME, "meas_tfall",
+                              "meas tran meas_tfall TRIG " + vec + " VAL=" + hi + " FALL=1 TARG " + vec
+                              + " VAL=" + lo + " FALL=1"});
+        }
+        checks.push_back({MEAS_RMS, "meas_rms", "meas tran meas_rms RMS " + vec});
+        checks.push_back({MEAS_AVERAGE, "meas_avg", "meas tran meas_avg AVG " + vec});
+        checks.push_back({MEAS_PEAK_TO_PEAK, "meas_pp", "meas tran meas_pp PP " + vec});
+    } else if (lowerCopy(vec).rfind("v(", 0) == 0) {
+        // meas on AC data works on a derived real quantity: use vdb(node)
+        const std::string vdb = "vdb(" + vec.substr(2);
+        std::vector<double> y;
+        int stride = 1;
+        if (fetchVector(plot + "." + vec, y, stride) && y.size() >= (size_t) stride) {
+            const double re = y[0], im = (stride == 2) ? y[1] : 0.0;
+            const double refDb = 10.0 * std::log10(re * re + im * im);
+            checks.push_back({MEAS_BANDWIDTH_3DB, "meas_bw",
+                              "meas ac meas_bw WHEN " + vdb + "=" + fmtDouble(refDb - 3.0102999566398120)
+                              + " FALL=1"});
+        }
+        checks.push_back({MEAS_RESONANCE_FREQ, "meas_fpk", "meas ac meas_fpk MAX_AT " + vdb});
+    }
+
+    // meas works on the current plot and leaves its result there.
+    const char* cur = ngSpice_CurPlot();
+    const std::string previous = cur ? cur : "";
+    if (plot != previous) runCommand(("setplot " + plot).c_str());
+
+    std::string report;
+    char buf[160];
+    for (const Check& c : checks) {
+        if (!wants(c.kind)) continue;
+        const double ours = native[c.kind];
+        double theirs = 0.0;
+        if (!ngspiceMeas(c.name, c.cmd, theirs)) {
+            std::snprintf(buf, sizeof buf, "%s: native=%.6g ngspice meas failed\n", c.name, ours);
+        } else {
+            const double rel = (theirs != 0.0) ? std::fabs(ours - theirs) / std::fabs(theirs) : std::fabs(ours);
+            std::snprintf(buf, sizeof buf, "%s: native=%.6g ngspice=%.6g rel=%.2e\n", c.name, ours, theirs, rel);
+        }
+        report += buf;
+    }
+    if (report.empty()) report = "[WARN] no measurements with an ngspice meas equivalent requested\n";
+    if (plot != previous && !previous.empty()) runCommand(("setplot " + previous).c_str());
+
+    return env->NewStringUTF(report.c_str());
+}
+
+/* -------------------- spectrum -------------------- */
+
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_analyzeSpectrum(JNIEnv* env, jobject /*thiz*/, jstring plotName,
+                                                             jstring vecName, jint nfft, jint window,
+                                                             jdouble fundamentalHz, jint harmonics,
+                                                             jdouble tStart, jdouble tStop)
+{
+    const std::string plotArg = jstringToStd(env, plotName);
+    const std::string vecArg = jstringToStd(env, vecName);
+
+    SpectrumConfig cfg;
+    cfg.nfft = nfft > 0 ? (size_t) nfft : 0;
+    cfg.window = (window >= 0 && window < WIN_COUNT) ? (SpectrumWindow) window : WIN_HANN;
+    cfg.fundamentalHz = fundamentalHz;
+    cfg.harmonics = harmonics;
+    cfg.tStart = tStart;
+    cfg.tStop = tStop;
+
+    std::vector<double> t, y;
+    int stride = 1;
+    {
+        std::lock_guard<std::mutex> lock(g_spiceMutex);
+        std::string vec;
+        const std::string plot = resolvePlot(plotArg, vecArg, vec);
+        if (plot.empty() || !fetchScale(plot + ".time", t) || !fetchVector(plot + "." + vec, y, stride)
+            || stride != 1) {
+            return toJDoubleArray(env, std::vector<double>(SPEC_STAT_COUNT,
+                                                           std::numeric_limits<double>::quiet_NaN()));
+        }
+    }
+
+    const size_t n = std::min(t.size(), y.size());
+    SpectrumResult res = ::analyzeSpectrum(t.data(), y.data(), n, cfg);
+
+    std::vector<double> rows(3 * res.magnitude.size());
+    const double binHz = res.stats[SPEC_BIN_HZ];
+    for (size_t k = 0; k < res.magnitude.size(); ++k) {
+        rows[3 * k] = (double) k * binHz;
+        rows[3 * k + 1] = res.magnitude[k];
+        rows[3 * k + 2] = res.phaseDeg[k];
+    }
+    {
+        std::lock_guard<std::mutex> lk(g_dataMutex);
+        g_spectrum.swap(rows);
+    }
+    return toJDoubleArray(env, res.stats);
+}
+
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_takeSpectrum(JNIEnv* env, jobject /*thiz*/)
+{
+    std::vector<double> tmp;
+    {
+        std::lock_guard<std::mutex> lk(g_dataMutex);
+        tmp.swap(g_spectrum);
+    }
+    return toJDoubleArray(env, tmp);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_benchmarkSpectrum(JNIEnv* env, jobject /*thiz*/, jint points,
+                                                               jint iterations)
+{
+    const std::string report = runSpectrumBenchmark(points > 0 ? (size_t) points : 1000000, iterations);
+    return env->NewStringUTF(report.c_str());
+}
+
+/* -------------------- adaptive AC sweep -------------------- */
+
+// Names of every vector in a plot, in ngspice's order.
+static std::vector<std::string> plotVecNames(const std::string& plot)
+{
+    std::vector<std::string> names;
+    char** vecs = ngSpice_AllVecs(const_cast<char*>(plot.c_str()));
+    for (int i = 0; vecs && vecs[i]; ++i) names.emplace_back(vecs[i]);
+    return names;
+}
+
+// Copy the named vectors of a plot into stride-2 rows (real vectors get im = 0).
+static bool harvestComplexRows(const std::string& plot, const std::vector<std::string>& names,
+                               std::vector<double>& rows)
+{
+    const size_t vecCount = names.size();
+    std::vector<std::vector<double>> cols(vecCount);
+    std::vector<int> strides(vecCount, 1);
+    size_t n = std::numeric_limits<size_t>::max();
+    for (size_t v = 0; v < vecCount; ++v) {
+        if (!fetchVector(plot + "." + names[v], cols[v], strides[v])) return false;
+        n = std::min(n, cols[v].size() / strides[v]);
+    }
+
+    rows.assign(n * 2 * vecCount, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        double* row = rows.data() + i * 2 * vecCount;
+        for (size_t v = 0; v < vecCount; ++v) {
+            row[2 * v] = cols[v][i * strides[v]];
+            row[2 * v + 1] = (strides[v] == 2) ? cols[v][i * 2 + 1] : 0.0;
+        }
+    }
+    return true;
+}
+
+static void setMeasSuspended(bool suspended)
+{
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    g_measSuspended = suspended;
+}
+
+// Feed an armed measurement session from stride-2 rows (the merged adaptive
+// sweep) instead of from a streamed analysis. Caller holds g_dataMutex.
+static void measureSweepRows(const std::vector<double>& rows, const std::vector<std::string>& names)
+{
+    const size_t vecCount = names.size();
+    size_t vecIndex = vecCount, scaleIndex = vecCount;
+    for (size_t v = 0; v < vecCount; ++v) {
+        const std::string name = lowerCopy(names[v]);
+        if (name == g_measVecName) vecIndex = v;
+        if (name == g_measScaleName) scaleIndex = v;
+    }
+    if (vecIndex == vecCount || scaleIndex == vecCount) return;
+
+    g_measurer.reset();
+    for (size_t i = 0; i < rows.size() / (2 * vecCount); ++i) {
+        const double* row = rows.data() + i * 2 * vecCount;
+        g_measurer.push(row[2 * scaleIndex], row[2 * vecIndex], row[2 * vecIndex + 1]);
+    }
+    g_measArmed = false;
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_runAdaptiveAC(JNIEnv* env, jobject /*thiz*/, jstring netlist,
+                                                           jdouble fStart, jdouble fStop, jint pointsPerDecade,
+                                                           jint refinePoints, jint maxPasses,
+                                                           jdouble dbTolerance, jdouble phaseToleranceDeg)
+{
+    std::lock_guard<std::mutex> lock(g_spiceMutex);
+
+    if (!g_initialized.load(std::memory_order_acquire)) {
+        return env->NewStringUTF("ERROR: ngspice not initialized\n");
+    }
+
+    const std::string netlistStr = jstringToStd(env, netlist);
+
+    clearOutput();
+    g_storeComplex = true;
+    if (loadCircuit(netlistStr) != 0) {
+        std::string out = takeOutputSnapshot();
+        return env->NewStringUTF(out.c_str());
+    }
+
+    // Sub-runs must not bind an armed measurement session; it gets the merged sweep instead.
+    setMeasSuspended(true);
+
+    AcRefineConfig cfg;
+    cfg.refinePoints = std::max(3, (int) refinePoints);
+    // Zero, negative or NaN tolerances would ask for unbounded refinement.
+    cfg.dbTolerance = std::max(0.01, (double) dbTolerance);
+    cfg.phaseToleranceDeg = std::max(0.1, (double) phaseToleranceDeg);
+
+    char cmd[128];
+    std::snprintf(cmd, sizeof cmd, "ac dec %d %.17g %.17g", std::max(1, (int) pointsPerDecade), fStart, fStop);
+
+    // The coarse plot fixes the vector order for everything merged into it.
+    const std::string coarsePlot = runForNewPlot(cmd);
+    if (coarsePlot.empty()) {
+        std::string out = takeOutputSnapshot();
+        out += "\n[WARN] adaptive AC: coarse sweep \"" + std::string(cmd) + "\" produced no plot\n";
+        setMeasSuspended(false);
+        return env->NewStringUTF(out.c_str());
+    }
+    const std::vector<std::string> names = plotVecNames(coarsePlot);
+    size_t freqIndex = names.size();
+    for (size_t v = 0; v < names.size(); ++v) {
+        if (lowerCopy(names[v]) == "frequency") freqIndex = v;
+    }
+
+    std::vector<double> rows;
+    if (freqIndex == names.size() || !harvestComplexRows(coarsePlot, names, rows)) {
+        std::string out = takeOutputSnapshot();
+        out += "\n[WARN] adaptive AC: coarse sweep produced no frequency data\n";
+        setMeasSuspended(false);
+        return env->NewStringUTF(out.c_str());
+    }
+    const size_t coarseCount = rows.size() / (2 * names.size());
+
+    size_t solved = coarseCount;
+    size_t refinedIntervals = 0;
+    int passes = 0;
+    std::vector<RefineInterval> history;
+    for (; passes < maxPasses; ++passes) {
+        const auto intervals = findRefineIntervals(rows, names.size(), freqIndex, cfg, history);
+        if (intervals.empty()) break;
+
+        std::vector<double> extra;
+        for (const auto& iv : intervals) {
+            // Re-runs the already loaded circuit; only the sweep changes.
+            const std::string plot = runForNewPlot(refineCommand(iv, cfg));
+            if (plot.empty()) continue;
+
+            std::vector<double> part;
+            if (harvestComplexRows(plot, names, part)) {
+                extra.insert(extra.end(), part.begin(), part.end());
+                solved += part.size() / (2 * names.size());
+            }
+            runCommand(("destroy " + plot).c_str());
+        }
+        refinedIntervals += intervals.size();
+        mergeSweepRows(rows, extra, names.size(), freqIndex);
+    }
+
+    // Publish the merged sweep through the regular sample path.
+    const size_t total = rows.size() / (2 * names.size());
+    supersedePlots("adaptive ac", coarsePlot);
+    {
+        std::lock_guard<std::mutex> lk(g_dataMutex);
+        g_vecNames = names;
+        g_vecCount = (int) names.size();
+        g_samples = rows;
+        g_storeComplex = true;
+
+        g_measSuspended = false;
+        if (g_measArmed) measureSweepRows(rows, names);
+
+        PlotData data;
+        data.command = "adaptive ac";
+        data.vecNames = names;
+        data.samples.swap(rows);
+        data.complex = true;
+        storePlot(coarsePlot, std::move(data));
+    }
+
+    std::string out = takeOutputSnapshot();
+    std::snprintf(cmd, sizeof cmd, "[adaptive ac] %zu coarse + %zu refined points (%zu intervals, %d passes), %zu merged\n",
+                  coarseCount, solved - coarseCount, refinedIntervals, passes, total);
+    out += cmd;
+    return env->NewStringUTF(out.c_str());
+}
+
+/* -------------------- batch runs / plot store -------------------- */
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_runAnalyses(JNIEnv* env, jobject /*thiz*/, jstring netlist,
+                                                         jobjectArray analysisCmds)
+{
+    std::lock_guard<std::mutex> lock(g_spiceMutex);
+
+    if (!g_initialized.load(std::memory_order_acquire)) {
+        return env->NewStringUTF("ERROR: ngspice not initialized\n");
+    }
+
+    const std::string netlistStr = jstringToStd(env, netlist);
+    std::vector<std::string> cmds;
+    const jsize cmdCount = analysisCmds ? env->GetArrayLength(analysisCmds) : 0;
+    for (jsize i = 0; i < cmdCount; ++i) {
+        jstring js = (jstring) env->GetObjectArrayElement(analysisCmds, i);
+        cmds.push_back(jstringToStd(env, js));
+        env->DeleteLocalRef(js);
+    }
+
+    clearOutput();
+
+    // One parse and setup for the whole batch.
+    if (loadCircuit(netlistStr) != 0) {
+        std::string out = takeOutputSnapshot();
+        return env->NewStringUTF(out.c_str());
+    }
+
+    std::string summary;
+    for (const std::string& cmd : cmds) {
+        const std::string plot = runAndRecord(cmd, true);
+        summary += "[batch] " + cmd + " -> " + (plot.empty() ? "no new plot" : plot) + "\n";
+    }
+
+    std::string out = takeOutputSnapshot();
+    out += summary;
+    return env->NewStringUTF(out.c_str());
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_getPlotNames(JNIEnv* env, jobject /*thiz*/)
+{
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    return toJStringArray(env, g_plotOrder);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_getPlotCommand(JNIEnv* env, jobject /*thiz*/, jstring plot)
+{
+    const std::string name = jstringToStd(env, plot);
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    auto it = g_plots.find(name);
+    return env->NewStringUTF(it != g_plots.end() ? it->second.command.c_str() : "");
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_getPlotVecNames(JNIEnv* env, jobject /*thiz*/, jstring plot)
+{
+    const std::string name = jstringToStd(env, plot);
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    auto it = g_plots.find(name);
+    return toJStringArray(env, it != g_plots.end() ? it->second.vecNames : std::vector<std::string>());
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_getPlotComplexStride(JNIEnv* env, jobject /*thiz*/, jstring plot)
+{
+    const std::string name = jstringToStd(env, plot);
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    auto it = g_plots.find(name);
+    return (it != g_plots.end() && it->second.complex) ? 2 : 1;
+}
+
+extern "C"
+JNIEXPORT jdoubleArray JNICALL
+Java_com_devinrcohen_droidspice_MainActivity_getPlotSamples(JNIEnv* env, jobject /*thiz*/, jstring plot)
+{
+    // Unlike takeSamples this does not drain: each plot can be queried repeatedly.
+    const std::string name = jstringToStd(env, plot);
+    std::lock_guard<std::mutex> lk(g_dataMutex);
+    auto it = g_plots.find(name);
+    return toJDoubleArray(env, it != g_plots.end() ? it->second.samples : std::vector<double>());
 }
@@ -0,0 +1,435 @@
+#include "spectrum.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <utility>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define SPECTRUM_SIMD "neon"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SPECTRUM_SIMD "sse2"
+#else
+#define SPECTRUM_SIMD "scalar"
+#endif
+
+static const double kNaN = std::numeric_limits<double>::quiet_NaN();
+// Enough for a 1M-point capture; keeps a plan plus window around 20 MB.
+static const size_t kMaxFft = size_t(1) << 20;
+static const size_t kCacheSlots = 3;
+
+static size_t nextPow2(size_t n)
+{
+    size_t p = 4;
+    while (p < n && p < kMaxFft) p <<= 1;
+    return p;
+}
+
+/* -------------------- plan / window caches -------------------- */
+
+static std::shared_ptr<const FftPlan> buildPlan(size_t n)
+{
+    auto plan = std::make_shared<FftPlan>();
+    plan->n = n;
+    plan->half = n / 2;
+    const size_t m = plan->half;
+
+    unsigned bits = 0;
+    while ((size_t(1) << bits) < m) ++bits;
+    plan->bitrev.resize(m);
+    for (size_t i = 0; i < m; ++i) {
+        unsigned r = 0;
+        for (unsigned b = 0; b < bits; ++b) {
+            if (i & (size_t(1) << b)) r |= 1u << (bits - 1 - b);
+        }
+        plan->bitrev[i] = r;
+    }
+
+    plan->twiddles.resize(2 * m);
+    for (size_t k = 0; k < m; ++k) {
+        const double a = -2.0 * M_PI * (double) k / (double) n;
+        plan->twiddles[2 * k] = std::cos(a);
+        plan->twiddles[2 * k + 1] = std::sin(a);
+    }
+    return plan;
+}
+
+// Small most-recently-used cache; the caller holds the cache mutex.
+template <typename Value, typename Build>
+static std::shared_ptr<const Value> cachedLookup(
+        std::vector<std::pair<size_t, std::shared_ptr<const Value>>>& slots, size_t key, Build build)
+{
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].first != key) continue;
+        std::rotate(slots.begin(), slots.begin() + i, slots.begin() + i + 1);
+        return slots.front().second;
+    }
+    std::shared_ptr<const Value> v = build();
+    slots.insert(slots.begin(), {key, v});
+    if (slots.size() > kCacheSlots) slots.pop_back();
+    return v;
+}
+
+std::shared_ptr<const FftPlan> getFftPlan(size_t n)
+{
+    static std::mutex cacheMutex;
+    static std::vector<std::pair<size_t, std::shared_ptr<const FftPlan>>> cache;
+
+    std::lock_guard<std::mutex> lk(cacheMutex);
+    return cachedLookup(cache, n, [n] { return buildPlan(n); });
+}
+
+// Periodic (DFT-even) windows
+static std::shared_ptr<const std::vector<double>> buildWindow(size_t n, SpectrumWindow type)
+{
+    auto w = std::make_shared<std::vector<double>>(n, 1.0);
+    double a[5] = {1.0, 0.0, 0.0, 0.0, 0.0};
+    switch (type) {
+        case WIN_HANN:     a[0] = 0.5;  a[1] = 0.5; break;
+        case WIN_HAMMING:  a[0] = 0.54; a[1] = 0.46; break;
+        case WIN_BLACKMAN: a[0] = 0.42; a[1] = 0.5; a[2] = 0.08; break;
+        case WIN_FLATTOP:
+            a[0] = 0.21557895; a[1] = 0.41663158; a[2] = 0.277263158;
+            a[3] = 0.083578947; a[4] = 0.006947368;
+            break;
+        default: return w;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const double x = 2.0 * M_PI * (double) i / (double) n;
+        double v = a[0];
+        double sign = -1.0;
+        for (int j = 1; j < 5; ++j) {
+            v += sign * a[j] * std::cos(j * x);
+            sign = -sign;
+        }
+        (*w)[i] = v;
+    }
+    return w;
+}
+
+std::shared_ptr<const std::vector<double>> getWindow(size_t n, SpectrumWindow type)
+{
+    static std::mutex cacheMutex;
+    static std::vector<std::pair<size_t, std::shared_ptr<const std::vector<double>>>> cache;
+
+    const size_t key = n * WIN_COUNT + (size_t) type;
+    std::lock_guard<std::mutex> lk(cacheMutex);
+    return cachedLookup(cache, key, [n, type] { return buildWindow(n, type); });
+}
+
+// Main-lobe half width in bins, used to gather a tone's power
+static size_t lobeBins(SpectrumWindow type)
+{
+    switch (type) {
+        case WIN_HANN:
+        case WIN_HAMMING:  return 2;
+        case WIN_BLACKMAN: return 3;
+        case WIN_FLATTOP:  return 5;
+        default:           return 1;
+    }
+}
+
+/* -------------------- resample -------------------- */
+
+void resampleUniform(const double* t, const double* y, size_t n,
+                     double t0, double dt, size_t m, double* out)
+{
+    if (n == 0) {
+        std::fill(out, out + m, 0.0);
+        return;
+    }
+    size_t i = 0;
+    for (size_t j = 0; j < m; ++j) {
+        const double tj = t0 + (double) j * dt;
+        while (i + 1 < n && t[i + 1] < tj) ++i;
+        if (i + 1 >= n || tj <= t[i]) {
+            out[j] = (tj <= t[0]) ? y[0] : y[std::min(i + 1, n - 1)];
+            continue;
+        }
+        const double span = t[i + 1] - t[i];
+        // ngspice repeats timepoints at breakpoints
+        out[j] = (span > 0.0) ? y[i] + (y[i + 1] - y[i]) * (tj - t[i]) / span : y[i + 1];
+    }
+}
+
+/* -------------------- FFT -------------------- */
+
+// In-place radix-2 DIT on m interleaved complex values.
+static void complexFft(const FftPlan& plan, double* data)
+{
+    const size_t m = plan.half;
+    for (size_t i = 0; i < m; ++i) {
+        const size_t r = plan.bitrev[i];
+        if (r > i) {
+            std::swap(data[2 * i], data[2 * r]);
+            std::swap(data[2 * i + 1], data[2 * r + 1]);
+        }
+    }
+
+    // Stage with half-size h uses w_k = exp(-i*pi*k/h) = twiddles[2 * k * stride]
+    const double* tw = plan.twiddles.data();
+    for (size_t h = 1; h < m; h <<= 1) {
+        const size_t len = h << 1;
+        const size_t step = 2 * (m / h);
+        for (size_t i = 0; i < m; i += len) {
+            double* a = data + 2 * i;
+            double* b = data + 2 * (i + h);
+            for (size_t k = 0; k < h; ++k) {
+                const double* w = tw + k * step;
+#if defined(__aarch64__)
+                // t = w * b = (wr, wi) * br + (-wi, wr) * bi
+                static const float64x2_t flip = {-1.0, 1.0};
+                const float64x2_t vw = vld1q_f64(w);
+                const float64x2_t va = vld1q_f64(a + 2 * k);
+                const float64x2_t vb = vld1q_f64(b + 2 * k);
+                const float64x2_t vws = vmulq_f64(vextq_f64(vw, vw, 1), flip);
+                const float64x2_t t = vfmaq_f64(vmulq_f64(vw, vdupq_laneq_f64(vb, 0)),
+                                                vws, vdupq_laneq_f64(vb, 1));
+                vst1q_f64(a + 2 * k, vaddq_f64(va, t));
+                vst1q_f64(b + 2 * k, vsubq_f64(va, t));
+#elif defined(__SSE2__)
+                const __m128d flip = _mm_set_pd(0.0, -0.0); // sign bit of the low lane
+                const __m128d vw = _mm_loadu_pd(w);
+                const __m128d va = _mm_loadu_pd(a + 2 * k);
+                const __m128d vb = _mm_loadu_pd(b + 2 * k);
+                const __m128d vws = _mm_xor_pd(_mm_shuffle_pd(vw, vw, 1), flip);
+                const __m128d t = _mm_add_pd(_mm_mul_pd(vw, _mm_unpacklo_pd(vb, vb)),
+                                             _mm_mul_pd(vws, _mm_unpackhi_pd(vb, vb)));
+                _mm_storeu_pd(a + 2 * k, _mm_add_pd(va, t));
+                _mm_storeu_pd(b + 2 * k, _mm_sub_pd(va, t));
+#else
+                const double br = b[2 * k], bi = b[2 * k + 1];
+                const double tr = w[0] * br - w[1] * bi;
+                const double ti = w[1] * br + w[0] * bi;
+                const double ar = a[2 * k], ai = a[2 * k + 1];
+                a[2 * k] = ar + tr;
+                a[2 * k + 1] = ai + ti;
+                b[2 * k] = ar - tr;
+                b[2 * k + 1] = ai - ti;
+#endif
+            }
+        }
+    }
+}
+
+void realFft(const FftPlan& plan, const double* in, double* out)
+{
+    // Pack even/odd samples as one half-length complex sequence, transform,
+    // then split into the n/2 + 1 bins of the real transform.
+    const size_t m = plan.half;
+    std::vector<double> z(in, in + plan.n);
+    complexFft(plan, z.data());
+
+    out[0] = z[0] + z[1];
+    out[1] = 0.0;
+    out[2 * m] = z[0] - z[1];
+    out[2 * m + 1] = 0.0;
+
+    for (size_t k = 1; k < m; ++k) {
+        const double zr = z[2 * k], zi = z[2 * k + 1];
+        const double cr = z[2 * (m - k)], ci = -z[2 * (m - k) + 1];
+        const double er = 0.5 * (zr + cr), ei = 0.5 * (zi + ci);
+        const double orr = 0.5 * (zi - ci), oi = -0.5 * (zr - cr);
+        const double wr = plan.twiddles[2 * k], wi = plan.twiddles[2 * k + 1];
+        out[2 * k] = er + wr * orr - wi * oi;
+        out[2 * k + 1] = ei + wr * oi + wi * orr;
+    }
+}
+
+/* -------------------- analysis -------------------- */
+
+SpectrumResult analyzeSpectrum(const double* t, const double* y, size_t n, const SpectrumConfig& cfg)
+{
+    SpectrumResult res;
+    res.stats.assign(SPEC_STAT_COUNT, kNaN);
+    if (n < 2) return res;
+
+    const double t0 = std::isnan(cfg.tStart) ? t[0] : cfg.tStart;
+    const double t1 = std::isnan(cfg.tStop) ? t[n - 1] : cfg.tStop;
+    if (!(t1 > t0)) return res;
+
+    size_t nfft = cfg.nfft;
+    if (nfft == 0) {
+        const size_t lo = std::lower_bound(t, t + n, t0) - t;
+        const size_t hi = std::upper_bound(t, t + n, t1) - t;
+        nfft = (hi > lo) ? hi - lo : n;
+    }
+    nfft = nextPow2(nfft);
+
+    auto plan = getFftPlan(nfft);
+    auto window = getWindow(nfft, cfg.window);
+
+    // Periodic grid: the endpoint t1 belongs to the next period
+    const double dt = (t1 - t0) / (double) nfft;
+    const double binHz = 1.0 / (t1 - t0);
+
+    std::vector<double> buf(nfft);
+    resampleUniform(t, y, n, t0, dt, nfft, buf.data());
+
+    double sumW = 0.0, sumW2 = 0.0;
+    const std::vector<double>& w = *window;
+    for (size_t i = 0; i < nfft; ++i) {
+        buf[i] *= w[i];
+        sumW += w[i];
+        sumW2 += w[i] * w[i];
+    }
+    const double enbw = (double) nfft * sumW2 / (sumW * sumW);
+
+    const size_t m = plan->half;
+    std::vector<double> bins(2 * (m + 1));
+    realFft(*plan, buf.data(), bins.data());
+
+    res.magnitude.resize(m + 1);
+    res.phaseDeg.resize(m + 1);
+    std::vector<double> power(m + 1);
+    for (size_t k = 0; k <= m; ++k) {
+        const double re = bins[2 * k], im = bins[2 * k + 1];
+        const double scale = (k == 0 || k == m) ? 1.0 / sumW : 2.0 / sumW;
+        res.magnitude[k] = std::sqrt(re * re + im * im) * scale;
+        res.phaseDeg[k] = std::atan2(im, re) * 180.0 / M_PI;
+        power[k] = res.magnitude[k] * res.magnitude[k];
+    }
+    res.stats[SPEC_BIN_HZ] = binHz;
+
+    // Locate the fundamental
+    const size_t lobe = lobeBins(cfg.window);
+    if (m <= lobe + 1) return res;
+    size_t searchLo = lobe + 1, searchHi = m;
+    if (cfg.fundamentalHz > 0.0) {
+        const size_t guess = (size_t) std::llround(cfg.fundamentalHz / binHz);
+        searchLo = std::max(searchLo, guess > lobe ? guess - lobe : 0);
+        searchHi = std::min(m, guess + lobe);
+    }
+    // e.g. a hint above Nyquist: there is no tone to measure
+    if (searchLo > searchHi) return res;
+    size_t k0 = searchLo;
+    for (size_t k = searchLo + 1; k <= searchHi; ++k) {
+        if (power[k] > power[k0]) k0 = k;
+    }
+
+    std::vector<unsigned char> used(m + 1, 0);
+    auto gather = [&](size_t center) {
+        double p = 0.0;
+        const size_t lo = center > lobe ? center - lobe : 0;
+        const size_t hi = std::min(m, center + lobe);
+        for (size_t k = lo; k <= hi; ++k) {
+            if (used[k]) continue;
+            used[k] = 1;
+            p += power[k];
+        }
+        return p;
+    };
+
+    gather(0); // DC is excluded from every figure below
+
+    double centroidNum = 0.0, centroidDen = 0.0;
+    for (size_t k = (k0 > lobe ? k0 - lobe : 0); k <= std::min(m, k0 + lobe); ++k) {
+        if (used[k]) continue;
+        centroidNum += (double) k * power[k];
+        centroidDen += power[k];
+    }
+    const double f0 = (centroidDen > 0.0) ? centroidNum / centroidDen * binHz : (double) k0 * binHz;
+    const double pSig = gather(k0);
+
+    // Harmonics, folded back into the first Nyquist zone
+    const double fs = (double) nfft * binHz;
+    double pHarm = 0.0;
+    for (int h = 2; h <= cfg.harmonics; ++h) {
+        double fh = std::fmod((double) h * f0, fs);
+        if (fh > fs / 2.0) fh = fs - fh;
+        pHarm += gather((size_t) std::llround(fh / binHz));
+    }
+
+    double pTotal = 0.0;
+    double pNoise = 0.0;
+    size_t noiseBins = 0;
+    for (size_t k = lobe + 1; k <= m; ++k) pTotal += power[k];
+    for (size_t k = 0; k <= m; ++k) {
+        if (used[k]) continue;
+        pNoise += power[k];
+        ++noiseBins;
+    }
+
+    res.stats[SPEC_FUNDAMENTAL_HZ] = f0;
+    res.stats[SPEC_FUNDAMENTAL_AMP] = std::sqrt(pSig / enbw);
+    if (pSig > 0.0) {
+        res.stats[SPEC_THD_PERCENT] = 100.0 * std::sqrt(pHarm / pSig);
+        res.stats[SPEC_THD_DB] = 10.0 * std::log10(pHarm / pSig);
+        const double sinad = 10.0 * std::log10(pSig / std::max(pTotal - pSig, 1e-300));
+        res.stats[SPEC_SINAD_DB] = sinad;
+        res.stats[SPEC_ENOB] = (sinad - 1.76) / 6.02;
+        if (noiseBins > 0) {
+            res.stats[SPEC_NOISE_FLOOR_DBC] = 10.0 * std::log10(std::max(pNoise / noiseBins, 1e-300) / pSig);
+        }
+    }
+    return res;
+}
+
+/* -------------------- benchmark -------------------- */
+
+std::string runSpectrumBenchmark(size_t points, int iterations)
+{
+    using clock = std::chrono::steady_clock;
+    if (points < 4) points = 4;
+    if (iterations < 1) iterations = 1;
+
+    // Non-uniform time axis like a transient run with a varying timestep
+    std::vector<double> t(points), y(points);
+    const double f0 = 1e3;
+    double now = 0.0;
+    uint32_t lcg = 12345u;
+    for (size_t i = 0; i < points; ++i) {
+        lcg = lcg * 1664525u + 1013904223u;
+        const double jitter = (double) (lcg >> 8) / (double) (1u << 24);
+        t[i] = now;
+        y[i] = std::sin(2.0 * M_PI * f0 * now) + 0.01 * std::sin(2.0 * M_PI * 3.0 * f0 * now);
+        now += 1e-8 * (0.5 + jitter);
+    }
+
+    const size_t nfft = nextPow2(points);
+    const double dt = (t.back() - t.front()) / (double) nfft;
+    std::vector<double> buf(nfft), bins(nfft + 2);
+
+    const auto c0 = clock::now();
+    auto plan = getFftPlan(nfft);
+    const auto c1 = clock::now();
+
+    double resampleMs = 0.0, fftMs = 0.0, fullMs = 0.0;
+    SpectrumResult last;
+    SpectrumConfig cfg;
+    cfg.nfft = nfft;
+    for (int it = 0; it < iterations; ++it) {
+        const auto a = clock::now();
+        resampleUniform(t.data(), y.data(), points, t.front(), dt, nfft, buf.data());
+        const auto b = clock::now();
+        realFft(*plan, buf.data(), bins.data());
+        const auto c = clock::now();
+        last = analyzeSpectrum(t.data(), y.data(), points, cfg);
+        const auto d = clock::now();
+        resampleMs += std::chrono::duration<double, std::milli>(b - a).count();
+        fftMs += std::chrono::duration<double, std::milli>(c - b).count();
+        fullMs += std::chrono::duration<double, std::milli>(d - c).count();
+    }
+    resampleMs /= iterations;
+    fftMs /= iterations;
+    fullMs /= iterations;
+
+    const auto rate = [points](double ms) { return ms > 0.0 ? (double) points / (ms * 1e3) : 0.0; };
+    char buf2[512];
+    std::snprintf(buf2, sizeof buf2,
+                  "spectrum benchmark (%s): %zu points, nfft=%zu, %d iterations\n"
+                  "  plan build: %.2f ms\n"
+                  "  resample:   %.2f ms (%.1f Msamples/s)\n"
+                  "  real FFT:   %.2f ms (%.1f Msamples/s)\n"
+                  "  full:       %.2f ms (%.1f Msamples/s)\n"
+                  "  f0=%.3f Hz THD=%.3f%% SINAD=%.1f dB\n",
+                  SPECTRUM_SIMD, points, nfft, iterations,
+                  std::chrono::duration<double, std::milli>(c1 - c0).count(),
+                  resampleMs, rate(resampleMs), fftMs, rate(fftMs), fullMs, rate(fullMs),
+                  last.stats[SPEC_FUNDAMENTAL_HZ], last.stats[SPEC_THD_PERCENT], last.stats[SPEC_SINAD_DB]);
+    return buf2;
+}
@@ -0,0 +1,78 @@
+#ifndef DROIDSPICE_SPECTRUM_H
+#define DROIDSPICE_SPECTRUM_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Window functions. Values must stay in sync with SpectrumWindow.kt.
+enum SpectrumWindow : int {
+    WIN_RECT = 0,
+    WIN_HANN,
+    WIN_HAMMING,
+    WIN_BLACKMAN,
+    WIN_FLATTOP,
+    WIN_COUNT
+};
+
+struct SpectrumConfig {
+    size_t nfft = 0;                 // 0: next power of two >= sample count (rounded up otherwise, max 2^20)
+    SpectrumWindow window = WIN_HANN;
+    double tStart = std::numeric_limits<double>::quiet_NaN(); // NaN: first sample
+    double tStop = std::numeric_limits<double>::quiet_NaN();  // NaN: last sample
+    double fundamentalHz = 0.0;      // 0: strongest non-DC bin
+    int harmonics = 10;              // highest harmonic (inclusive) counted as distortion
+};
+
+// Scalars are returned across JNI in this order (see SpectrumStat in SpectrumWindow.kt).
+enum SpectrumStat : int {
+    SPEC_BIN_HZ = 0,
+    SPEC_FUNDAMENTAL_HZ,
+    SPEC_FUNDAMENTAL_AMP,
+    SPEC_THD_PERCENT,
+    SPEC_THD_DB,
+    SPEC_SINAD_DB,
+    SPEC_NOISE_FLOOR_DBC,
+    SPEC_ENOB,
+    SPEC_STAT_COUNT
+};
+
+struct SpectrumResult {
+    std::vector<double> stats;       // SPEC_STAT_COUNT entries
+    std::vector<double> magnitude;   // single-sided peak amplitude per bin, nfft/2 + 1 entries
+    std::vector<double> phaseDeg;
+};
+
+// Twiddles and bit-reversal table for a power-of-two real FFT of size n.
+// Plans are immutable once built; getFftPlan() and getWindow() keep only the
+// few most recently used sizes.
+struct FftPlan {
+    size_t n = 0;                    // real input length
+    size_t half = 0;                 // complex FFT length (n / 2)
+    std::vector<unsigned> bitrev;    // half entries
+    // (cos, sin) of -2*pi*k/n for k < half. Serves the real split directly and,
+    // at even indices with a per-stage stride, every butterfly stage.
+    std::vector<double> twiddles;
+};
+
+std::shared_ptr<const FftPlan> getFftPlan(size_t n);
+std::shared_ptr<const std::vector<double>> getWindow(size_t n, SpectrumWindow type);
+
+// Linear resample of (t, y) onto m uniformly spaced points starting at t0 with
+// step dt. t must be non-decreasing, as ngspice's transient scale is.
+void resampleUniform(const double* t, const double* y, size_t n,
+                     double t0, double dt, size_t m, double* out);
+
+// Forward real FFT. out receives n/2 + 1 bins interleaved as (re, im).
+void realFft(const FftPlan& plan, const double* in, double* out);
+
+// Full pipeline on a captured transient vector: resample, window, FFT, then
+// fundamental/harmonic/noise power bookkeeping.
+SpectrumResult analyzeSpectrum(const double* t, const double* y, size_t n, const SpectrumConfig& cfg);
+
+// Synthetic throughput benchmark on a non-uniform capture of `points` samples.
+std::string runSpectrumBenchmark(size_t points, int iterations);
+
+#endif // DROIDSPICE_SPECTRUM_H
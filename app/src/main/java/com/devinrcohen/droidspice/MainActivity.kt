@@ -17,11 +17,53 @@ class MainActivity : AppCompatActivity() {
     private lateinit var plotBackCallback: androidx.activity.OnBackPressedCallback
 
     external fun initNgspice(): String
+    // Reloads the circuit only when the netlist changed. The result is readable through
+    // getVecNames/takeSamples and also stays in the plot store (see getPlotNames).
     external fun runAnalysis(netlist: String, analysisCmd: String): String
     external fun getVecNames(): Array<String>
     external fun takeSamples(): DoubleArray
     external fun getComplexStride(): Int
 
+    // params: [initial, final, lowFraction, highFraction, settleTolerance], see measure.h
+    // An armed session measures the next analysis that has both vectors, and only that one;
+    // runAdaptiveAC measures its merged sweep instead of any single sub-run.
+    external fun armMeasurements(vecName: String, scaleName: String, mask: Int, params: DoubleArray)
+    external fun takeMeasurements(): DoubleArray
+    // plot "" means the plot named by a "tran1.v(2)"-style vecName, else the current plot.
+    // Vector and scale are always read from that same plot.
+    external fun measureVector(plot: String, vecName: String, scaleName: String, mask: Int,
+                               params: DoubleArray): DoubleArray
+    external fun validateMeasurements(plot: String, vecName: String, scaleName: String, mask: Int,
+                                      params: DoubleArray): String
+
+    // Spectrum of a transient vector; plot selects it as for measureVector, and time is read from
+    // the same plot. nfft <= 0 picks the next power of two, fundamentalHz <= 0 searches for the
+    // strongest tone, NaN tStart/tStop use the full run.
+    // Returns scalars indexed by SpectrumStat; takeSpectrum() then yields [freq, magnitude, phaseDeg] rows.
+    external fun analyzeSpectrum(plot: String, vecName: String, nfft: Int, window: Int, fundamentalHz: Double,
+                                 harmonics: Int, tStart: Double, tStop: Double): DoubleArray
+    external fun takeSpectrum(): DoubleArray
+    external fun benchmarkSpectrum(points: Int, iterations: Int): String
+
+    // Coarse "ac dec" sweep refined with "ac lin" runs where the response bends or the phase
+    // jumps; the merged, frequency-sorted result is read back via getVecNames/takeSamples.
+    // Tolerances are clamped to at least 0.01 dB and 0.1 degrees.
+    external fun runAdaptiveAC(netlist: String, fStart: Double, fStop: Double, pointsPerDecade: Int,
+                               refinePoints: Int, maxPasses: Int, dbTolerance: Double,
+                               phaseToleranceDeg: Double): String
+
+    // Loads the netlist once (skipped if unchanged) and runs each command in order. Every analysis
+    // is kept under its ngspice plot name (op1, ac1, tran1, ...) and can be queried independently
+    // with the getPlot* functions until a different circuit is loaded; re-running a command
+    // replaces its earlier plot. The batch drains the streamed data, so getVecNames/takeSamples
+    // return nothing afterwards.
+    external fun runAnalyses(netlist: String, analysisCmds: Array<String>): String
+    external fun getPlotNames(): Array<String>
+    external fun getPlotCommand(plot: String): String
+    external fun getPlotVecNames(plot: String): Array<String>
+    external fun getPlotComplexStride(plot: String): Int
+    external fun getPlotSamples(plot: String): DoubleArray
+
     private fun norm(s: String) = s.trim().lowercase()
     fun dismissPlot() {
         hidePlotFragment()
@@ -216,7 +258,7 @@ class MainActivity : AppCompatActivity() {
         }
 
         binding.btnRunAC.setOnClickListener {
-            var response = runAnalysis(current_netlist, "ac dec 20 0.1 100meg")
+            var response = runAdaptiveAC(current_netlist, 0.1, 100e6, 10, 16, 6, 0.5, 10.0)
             //var response = runAnalysis(current_netlist, "tran 0.1u 1m")
             val names = getVecNames()
             val stride = getComplexStride() // 1 for real-only, 2 for real+imag
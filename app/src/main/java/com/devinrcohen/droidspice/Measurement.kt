@@ -0,0 +1,24 @@
+package com.devinrcohen.droidspice
+
+// Must stay in sync with MeasureKind in measure.h: the ordinal is both the
+// bit in the request mask and the index in the returned result array.
+enum class Measurement {
+    RISE_TIME,
+    FALL_TIME,
+    OVERSHOOT,
+    SETTLING_TIME,
+    RMS,
+    AVERAGE,
+    PEAK_TO_PEAK,
+    BANDWIDTH_3DB,
+    GAIN_MARGIN,
+    PHASE_MARGIN,
+    RESONANCE_FREQ,
+    RESONANCE_Q;
+
+    val bit: Int get() = 1 shl ordinal
+
+    companion object {
+        fun maskOf(vararg kinds: Measurement): Int = kinds.fold(0) { acc, k -> acc or k.bit }
+    }
+}
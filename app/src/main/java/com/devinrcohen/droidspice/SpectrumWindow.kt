@@ -0,0 +1,22 @@
+package com.devinrcohen.droidspice
+
+// Must stay in sync with SpectrumWindow in spectrum.h (passed by ordinal).
+enum class SpectrumWindow {
+    RECT,
+    HANN,
+    HAMMING,
+    BLACKMAN,
+    FLATTOP
+}
+
+// Index into the DoubleArray returned by analyzeSpectrum (SpectrumStat in spectrum.h).
+enum class SpectrumStat {
+    BIN_HZ,
+    FUNDAMENTAL_HZ,
+    FUNDAMENTAL_AMP,
+    THD_PERCENT,
+    THD_DB,
+    SINAD_DB,
+    NOISE_FLOOR_DBC,
+    ENOB
+}
@@ -0,0 +1,199 @@
+#include "adaptive_ac.h"
+#include "measure.h"
+#include "check.h"
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+typedef std::complex<double> Cplx;
+typedef std::function<Cplx(double)> Response;
+
+// Rows of (frequency, H(f)) plus, optionally, a vector of +-1e-19 noise as
+// found on the tail node of a symmetric pair.
+struct Sweep {
+    Response h;
+    bool noise = false;
+    unsigned seed = 1;
+
+    size_t vecCount() const { return noise ? 3 : 2; }
+
+    void append(std::vector<double>& rows, const std::vector<double>& freqs)
+    {
+        for (double f : freqs) {
+            const Cplx v = h(f);
+            rows.insert(rows.end(), {f, 0.0, v.real(), v.imag()});
+            if (noise) {
+                rows.push_back(next());
+                rows.push_back(next());
+            }
+        }
+    }
+
+    double next()
+    {
+        seed = seed * 1103515245u + 12345u;
+        return ((double) (seed >> 8) / (1u << 24) - 0.5) * 2e-19;
+    }
+};
+
+// The frequencies ngspice generates for "ac dec" / "ac lin".
+static std::vector<double> sweepFreqs(const std::string& cmd)
+{
+    char type[8];
+    int n = 0;
+    double f1 = 0.0, f2 = 0.0;
+    std::sscanf(cmd.c_str(), "ac %7s %d %lf %lf", type, &n, &f1, &f2);
+    std::vector<double> f;
+    if (std::string(type) == "dec") {
+        for (int i = 0;; ++i) {
+            const double x = f1 * std::pow(10.0, (double) i / n);
+            if (x > f2 * (1.0 + 1e-9)) break;
+            f.push_back(x);
+        }
+    } else {
+        for (int k = 0; k < n; ++k) f.push_back(n > 1 ? f1 + (f2 - f1) * k / (n - 1) : f1);
+    }
+    return f;
+}
+
+struct AdaptiveRun {
+    std::vector<double> rows;
+    size_t solved = 0;
+    size_t runs = 0;
+    bool overlapping = false;
+};
+
+// The same loop as runAdaptiveAC, with the response evaluated in place of ngspice.
+static AdaptiveRun adaptive(Sweep& s, double f1, double f2, const AcRefineConfig& cfg, int maxPasses = 6)
+{
+    AdaptiveRun r;
+    s.append(r.rows, sweepFreqs("ac dec 10 " + std::to_string(f1) + " " + std::to_string(f2)));
+    r.solved = r.rows.size() / (2 * s.vecCount());
+
+    std::vector<RefineInterval> history;
+    for (int pass = 0; pass < maxPasses; ++pass) {
+        const std::vector<RefineInterval> intervals = findRefineIntervals(r.rows, s.vecCount(), 0, cfg, history);
+        if (intervals.empty()) break;
+        std::vector<double> extra;
+        for (size_t k = 0; k < intervals.size(); ++k) {
+            if (k > 0 && intervals[k].f1 < intervals[k - 1].f2) r.overlapping = true;
+            const std::vector<double> f = sweepFreqs(refineCommand(intervals[k], cfg));
+            s.append(extra, f);
+            r.solved += f.size();
+            ++r.runs;
+        }
+        mergeSweepRows(r.rows, extra, s.vecCount(), 0);
+    }
+    return r;
+}
+
+static double resonanceQ(const std::vector<double>& rows, size_t vecCount)
+{
+    std::vector<double> f, y;
+    for (size_t i = 0; i < rows.size(); i += 2 * vecCount) {
+        f.push_back(rows[i]);
+        y.push_back(rows[i + 2]);
+        y.push_back(rows[i + 3]);
+    }
+    return measureTrace(f.data(), y.data(), f.size(), 2, 1u << MEAS_RESONANCE_Q, MeasureParams())[MEAS_RESONANCE_Q];
+}
+
+static void noiseVectorIsIgnored()
+{
+    // 1 kHz RC low-pass next to a vector of pure numerical noise: the noise
+    // must not be refined (it used to grow to over a thousand runs).
+    Sweep s;
+    s.h = [](double f) { return 1.0 / Cplx(1.0, f / 1e3); };
+    s.noise = true;
+    const AdaptiveRun r = adaptive(s, 0.1, 100e6, AcRefineConfig());
+    CHECK(r.runs == 0);
+}
+
+static void nonPositiveToleranceIsRejected()
+{
+    Sweep s;
+    s.h = [](double f) { return 1.0 / Cplx(1.0, f / 1e3); };
+    std::vector<double> rows;
+    s.append(rows, sweepFreqs("ac dec 10 1 1e6"));
+
+    AcRefineConfig cfg;
+    std::vector<RefineInterval> history;
+    cfg.dbTolerance = 0.0;
+    CHECK(findRefineIntervals(rows, 2, 0, cfg, history).empty());
+    cfg.dbTolerance = 0.5;
+    cfg.phaseToleranceDeg = -1.0;
+    CHECK(findRefineIntervals(rows, 2, 0, cfg, history).empty());
+}
+
+static void stalledIntervalsStop()
+{
+    // Q = 200 resonance at 10 kHz: flagged on the first pass...
+    Sweep s;
+    s.h = [](double f) { const Cplx j(0.0, f / 1e4); return 1.0 / (j * j + j / 200.0 + 1.0); };
+    std::vector<double> rows;
+    s.append(rows, sweepFreqs("ac dec 10 1 1e6"));
+    const AcRefineConfig cfg;
+    std::vector<RefineInterval> history;
+    CHECK(!findRefineIntervals(rows, 2, 0, cfg, history).empty());
+
+    // ...but not again over an unchanged sweep, since nothing improved.
+    CHECK(findRefineIntervals(rows, 2, 0, cfg, history).empty());
+}
+
+static void resonanceWithFewPoints()
+{
+    // Q = 200 needs about 2000 points/decade for a uniform sweep to resolve it
+    Sweep s;
+    s.h = [](double f) { const Cplx j(0.0, f / 1e4); return 1.0 / (j * j + j / 200.0 + 1.0); };
+    const AdaptiveRun r = adaptive(s, 0.1, 1e8, AcRefineConfig());
+    CHECK(!r.overlapping);
+    CHECK(r.solved < 300);
+    CHECK_NEAR(resonanceQ(r.rows, 2), 200.0, 2.0);
+}
+
+static void butterworthWithFewPoints()
+{
+    // 6th-order Butterworth, fc = 10 kHz: a 20 points/decade sweep (181
+    // points) still misses the response by 0.2 dB between its points.
+    Sweep s;
+    s.h = [](double f) {
+        const Cplx j(0.0, f / 1e4);
+        Cplx h = 1.0;
+        for (int k = 1; k <= 3; ++k) h /= j * j - 2.0 * std::cos(M_PI * (2 * k + 5) / 12.0) * j + 1.0;
+        return h;
+    };
+    const AdaptiveRun r = adaptive(s, 0.1, 1e8, AcRefineConfig());
+    CHECK(!r.overlapping);
+    CHECK(r.solved < 181);
+
+    // worst log-f interpolation error over the top 60 dB
+    const size_t n = r.rows.size() / 4;
+    double worst = 0.0;
+    size_t j = 0;
+    for (double f = 0.1; f < 1e8; f *= 1.001) {
+        const double exact = 20.0 * std::log10(std::abs(s.h(f)));
+        if (exact < -60.0) continue;
+        while (j + 2 < n && r.rows[4 * (j + 1)] < f) ++j;
+        const double* a = &r.rows[4 * j];
+        const double* b = &r.rows[4 * (j + 1)];
+        const double da = 20.0 * std::log10(std::hypot(a[2], a[3]));
+        const double db = 20.0 * std::log10(std::hypot(b[2], b[3]));
+        const double t = std::log10(f / a[0]) / std::log10(b[0] / a[0]);
+        worst = std::max(worst, std::fabs(da + t * (db - da) - exact));
+    }
+    CHECK(worst < 0.05);
+}
+
+int main()
+{
+    noiseVectorIsIgnored();
+    nonPositiveToleranceIsRejected();
+    stalledIntervalsStop();
+    resonanceWithFewPoints();
+    butterworthWithFewPoints();
+    return checkResult("adaptive_ac_test");
+}
@@ -0,0 +1,35 @@
+#ifndef DROIDSPICE_TEST_CHECK_H
+#define DROIDSPICE_TEST_CHECK_H
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal assertions for the host tests: report every failure, then let
+// main() return checkResult() so ctest sees a non-zero exit.
+static int g_checkFailures = 0;
+
+#define CHECK(cond)                                                               \
+    do {                                                                          \
+        if (!(cond)) {                                                            \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);  \
+            ++g_checkFailures;                                                    \
+        }                                                                         \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tol)                                         \
+    do {                                                                          \
+        const double a_ = (actual), e_ = (expected);                              \
+        if (!(std::fabs(a_ - e_) <= (tol))) {                                     \
+            std::printf("%s:%d: %s = %.9g, expected %.9g +- %.3g\n", __FILE__,    \
+                        __LINE__, #actual, a_, e_, (double) (tol));               \
+            ++g_checkFailures;                                                    \
+        }                                                                         \
+    } while (0)
+
+static int checkResult(const char* name)
+{
+    std::printf("%s: %s\n", name, g_checkFailures ? "FAILED" : "passed");
+    return g_checkFailures ? 1 : 0;
+}
+
+#endif // DROIDSPICE_TEST_CHECK_H
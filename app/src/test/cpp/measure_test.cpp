@@ -0,0 +1,115 @@
+#include "measure.h"
+#include "check.h"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+static uint32_t bits(std::initializer_list<MeasureKind> kinds)
+{
+    uint32_t m = 0;
+    for (MeasureKind k : kinds) m |= 1u << k;
+    return m;
+}
+
+// Non-uniform time grid on [0, span], denser near t = 0 like a transient run.
+static std::vector<double> timeGrid(size_t n, double span)
+{
+    std::vector<double> t(n);
+    for (size_t i = 0; i < n; ++i) t[i] = span * std::pow((double) i / (n - 1), 1.5);
+    return t;
+}
+
+static void rcStepResponse()
+{
+    // y = 1 - exp(-t), tau = 1: 10-90% rise = ln 9, 2% settling = ln 50
+    const double span = 10.0;
+    const std::vector<double> t = timeGrid(20001, span);
+    std::vector<double> y(t.size());
+    for (size_t i = 0; i < t.size(); ++i) y[i] = 1.0 - std::exp(-t[i]);
+
+    MeasureParams p;
+    p.initialValue = 0.0;
+    p.finalValue = 1.0;
+    const uint32_t mask = bits({MEAS_RISE_TIME, MEAS_SETTLING_TIME, MEAS_OVERSHOOT, MEAS_RMS,
+                                MEAS_AVERAGE, MEAS_PEAK_TO_PEAK});
+    const std::vector<double> r = measureTrace(t.data(), y.data(), t.size(), 1, mask, p);
+
+    const double e1 = std::exp(-span), e2 = std::exp(-2.0 * span);
+    CHECK_NEAR(r[MEAS_RISE_TIME], std::log(9.0), 1e-5);
+    CHECK_NEAR(r[MEAS_SETTLING_TIME], std::log(50.0), 1e-5);
+    CHECK_NEAR(r[MEAS_OVERSHOOT], 0.0, 1e-12);
+    CHECK_NEAR(r[MEAS_AVERAGE], (span - (1.0 - e1)) / span, 1e-6);
+    CHECK_NEAR(r[MEAS_RMS], std::sqrt((span - 2.0 * (1.0 - e1) + 0.5 * (1.0 - e2)) / span), 1e-6);
+    CHECK_NEAR(r[MEAS_PEAK_TO_PEAK], 1.0 - e1, 1e-12);
+
+    // not requested: NaN
+    CHECK(std::isnan(r[MEAS_FALL_TIME]));
+    CHECK(std::isnan(r[MEAS_BANDWIDTH_3DB]));
+}
+
+static void rcDischarge()
+{
+    const std::vector<double> t = timeGrid(20001, 10.0);
+    std::vector<double> y(t.size());
+    for (size_t i = 0; i < t.size(); ++i) y[i] = std::exp(-t[i]);
+
+    MeasureParams p;
+    p.finalValue = 0.0;
+    const std::vector<double> r = measureTrace(t.data(), y.data(), t.size(), 1, bits({MEAS_FALL_TIME}), p);
+    CHECK_NEAR(r[MEAS_FALL_TIME], std::log(9.0), 1e-5);
+}
+
+// Log sweep of H(f) into interleaved (re, im).
+template <typename H>
+static void sweep(double f1, double f2, int perDecade, H h, std::vector<double>& f, std::vector<double>& y)
+{
+    const int n = (int) std::lround(std::log10(f2 / f1) * perDecade) + 1;
+    f.resize(n);
+    y.resize(2 * n);
+    for (int i = 0; i < n; ++i) {
+        f[i] = f1 * std::pow(10.0, (double) i / perDecade);
+        const std::complex<double> v = h(f[i]);
+        y[2 * i] = v.real();
+        y[2 * i + 1] = v.imag();
+    }
+}
+
+static void bandPassQ10()
+{
+    // Second-order band-pass, f0 = 1 kHz, Q = 10
+    const double f0 = 1000.0, q = 10.0;
+    auto h = [&](double f) {
+        const std::complex<double> s(0.0, f / f0);
+        return (s / q) / (s * s + s / q + 1.0);
+    };
+    std::vector<double> f, y;
+    sweep(10.0, 100e3, 2000, h, f, y);
+
+    const std::vector<double> r = measureTrace(f.data(), y.data(), f.size(), 2,
+                                               bits({MEAS_RESONANCE_FREQ, MEAS_RESONANCE_Q}), MeasureParams());
+    CHECK_NEAR(r[MEAS_RESONANCE_FREQ], f0, f0 * 1e-3);
+    CHECK_NEAR(r[MEAS_RESONANCE_Q], q, q * 1e-3);
+}
+
+static void lowPassBandwidth()
+{
+    // First-order low-pass, corner 1 kHz: -3.01 dB exactly at the corner
+    auto h = [](double f) { return 1.0 / std::complex<double>(1.0, f / 1000.0); };
+    std::vector<double> f, y;
+    sweep(1.0, 1e6, 200, h, f, y);
+
+    const std::vector<double> r = measureTrace(f.data(), y.data(), f.size(), 2,
+                                               bits({MEAS_BANDWIDTH_3DB, MEAS_GAIN_MARGIN}), MeasureParams());
+    CHECK_NEAR(r[MEAS_BANDWIDTH_3DB], 1000.0, 1.0);
+    CHECK(std::isnan(r[MEAS_GAIN_MARGIN]));   // phase never reaches -180
+}
+
+int main()
+{
+    rcStepResponse();
+    rcDischarge();
+    bandPassQ10();
+    lowPassBandwidth();
+    return checkResult("measure_test");
+}
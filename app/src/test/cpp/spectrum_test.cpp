@@ -0,0 +1,86 @@
+#include "spectrum.h"
+#include "check.h"
+
+#include <cmath>
+#include <vector>
+
+static void fftMatchesDft()
+{
+    const size_t n = 1024;
+    std::vector<double> x(n);
+    unsigned seed = 12345;
+    for (double& v : x) {
+        seed = seed * 1103515245u + 12345u;
+        v = (double) (seed >> 8) / (1u << 24) - 0.5;
+    }
+
+    auto plan = getFftPlan(n);
+    std::vector<double> out(2 * (n / 2 + 1));
+    realFft(*plan, x.data(), out.data());
+
+    double worst = 0.0;
+    for (size_t k = 0; k <= n / 2; ++k) {
+        double re = 0.0, im = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            const double a = -2.0 * M_PI * (double) ((k * i) % n) / n;
+            re += x[i] * std::cos(a);
+            im += x[i] * std::sin(a);
+        }
+        worst = std::max(worst, std::hypot(out[2 * k] - re, out[2 * k + 1] - im));
+    }
+    CHECK_NEAR(worst, 0.0, 1e-9);
+}
+
+// 1 kHz tone of amplitude 1 with 1% third harmonic on a non-uniform grid:
+// THD = 1% (-40 dB), SINAD = 40 dB.
+static void toneWithHarmonic()
+{
+    const double span = 10e-3;
+    const size_t n = 20000;
+    std::vector<double> t(n), y(n);
+    for (size_t i = 0; i < n; ++i) {
+        const double u = (double) i / (n - 1);
+        t[i] = span * (u + 0.3 * u * (1.0 - u));
+        y[i] = std::sin(2.0 * M_PI * 1e3 * t[i]) + 0.01 * std::sin(2.0 * M_PI * 3e3 * t[i]);
+    }
+
+    SpectrumConfig cfg;
+    cfg.nfft = 16384;
+    cfg.window = WIN_BLACKMAN;
+    const SpectrumResult r = analyzeSpectrum(t.data(), y.data(), n, cfg);
+    CHECK_NEAR(r.stats[SPEC_BIN_HZ], 100.0, 1e-9);
+    CHECK_NEAR(r.stats[SPEC_FUNDAMENTAL_HZ], 1000.0, 1.0);
+    CHECK_NEAR(r.stats[SPEC_FUNDAMENTAL_AMP], 1.0, 1e-3);
+    CHECK_NEAR(r.stats[SPEC_THD_PERCENT], 1.0, 0.01);
+    CHECK_NEAR(r.stats[SPEC_THD_DB], -40.0, 0.1);
+    CHECK_NEAR(r.stats[SPEC_SINAD_DB], 40.0, 0.1);
+}
+
+// A fundamental hint selects the weaker tone; one above Nyquist finds nothing.
+static void fundamentalHint()
+{
+    const size_t n = 4096;
+    std::vector<double> t(n), y(n);
+    for (size_t i = 0; i < n; ++i) {
+        t[i] = (double) i / n * 0.1;
+        y[i] = std::sin(2.0 * M_PI * 400.0 * t[i]) + 0.1 * std::sin(2.0 * M_PI * 1000.0 * t[i]);
+    }
+
+    SpectrumConfig cfg;
+    cfg.fundamentalHz = 1000.0;
+    SpectrumResult r = analyzeSpectrum(t.data(), y.data(), n, cfg);
+    CHECK_NEAR(r.stats[SPEC_FUNDAMENTAL_HZ], 1000.0, 1.0);
+    CHECK_NEAR(r.stats[SPEC_FUNDAMENTAL_AMP], 0.1, 1e-3);
+
+    cfg.fundamentalHz = 1e6;
+    r = analyzeSpectrum(t.data(), y.data(), n, cfg);
+    CHECK(std::isnan(r.stats[SPEC_FUNDAMENTAL_HZ]));
+}
+
+int main()
+{
+    fftMatchesDft();
+    toneWithHarmonic();
+    fundamentalHint();
+    return checkResult("spectrum_test");
+}